@@ -0,0 +1,369 @@
+/**
+ * Benchmark for the engines of the epidemics simulation
+ * Every input is loaded once; the serial engine and the parallel engine for every thread count are run
+ * warmup times without being measured and then repetitions times, each run starting from the same initial state.
+ * One CSV row is written for every engine and thread count, with the median, mean, standard deviation and minimum
+ * of the measured runs, the speedup of the median over the serial median and the parallel efficiency (speedup / threads).
+ */
+
+#include <math.h>
+
+#include "epidemics.h"
+
+#define DEFAULT_REPETITIONS 5
+#define DEFAULT_WARMUP 1
+#define DEFAULT_STEPS 50
+#define MAX_THREAD_COUNTS 32
+#define MAX_BENCHMARK_INPUTS 64
+
+#define REPETITIONS_OPTION "--reps="
+#define WARMUP_OPTION "--warmup="
+#define STEPS_OPTION "--steps="
+#define THREADS_OPTION "--threads="
+#define OUTPUT_OPTION "--output="
+#define KERNELS_OPTION "--kernels="
+#define FUSED_OPTION "--fused"
+#define ACTIVE_OPTION "--active"
+#define GRID_OPTION "--grid="
+#define PTHREADS_OPTION "--pthreads"
+#define BARRIER_OPTION "--barrier="
+#define REORDER_OPTION "--reorder"
+#define CURVE_OPTION "--curve="
+
+#define BENCHMARK_CSV_HEADER "input,persons,steps,engine,kernels,threads,repetitions,median_s,mean_s,stddev_s,min_s,speedup,efficiency\n"
+
+// fisierele de intrare din repository, folosite cand nu e dat niciun fisier
+static const char *defaultInputs[] = {"epidemics10K.txt", "epidemics20K.txt", "epidemics50K.txt", "epidemics100K.txt"};
+
+typedef struct {
+    int repetitions;
+    int warmup;
+    int steps;
+    int threadCounts[MAX_THREAD_COUNTS];
+    int threadCountCount;
+    int fused;
+    int active;
+    int pthreads;
+    int barrierType;
+    int reorderEvery;           // -1 = fara reordonare, 0 = adaptiv
+    int curve;
+    int kernelType;
+    int gridType;
+    const char *outputPath;     // NULL = stdout
+    const char *inputs[MAX_BENCHMARK_INPUTS];
+    int inputCount;
+}BenchmarkOptions;
+
+typedef struct {
+    double median;
+    double mean;
+    double stddev;
+    double min;
+}TimingSummary;
+
+void benchmarkUsage();
+void parseBenchmarkOptions(int argc, const char *argv[], BenchmarkOptions *options);
+int parseThreadCounts(const char *list, int *threadCounts);
+TimingSummary timeEngine(SimulationEngine engine, CellIndex *grid, Population *initial, Population *work, SimulationData *simulation,
+                         BenchmarkOptions *options);
+TimingSummary summarizeTimes(double *times, int count);
+int compareTimes(const void *first, const void *second);
+
+int main(int argc, const char *argv[]) {
+    BenchmarkOptions options;
+    parseBenchmarkOptions(argc, argv, &options);
+    kernels = getKernels(options.kernelType);
+    barrierType = options.barrierType;
+
+    FILE *output = stdout;
+    if(options.outputPath) {
+        output = fopen(options.outputPath, "w");
+        if(!output) {
+            printf("File not found!\n");
+            exit(-1);
+        }
+    }
+    fprintf(output, BENCHMARK_CSV_HEADER);
+    fflush(output);
+
+    int maxThreads = 1;
+    for(int t=0;t<options.threadCountCount;t++) {
+        if(options.threadCounts[t] > maxThreads) maxThreads = options.threadCounts[t];
+    }
+    const char *parallelName = options.pthreads ? (options.barrierType == BARRIER_SPIN ? "pthreads_spin" : "pthreads_barrier") :
+                               options.active ? "parallel_active" : options.fused ? "parallel_fused" : "parallel";
+    SimulationEngine parallelEngine = options.pthreads ? simulatePthreads : options.active ? simulateParallelActive :
+                                      options.fused ? simulateParallelFused : simulateParallel;
+
+    for(int f=0;f<options.inputCount;f++) {
+        SimulationData simulation;
+        Population *initial = loadPopulation(options.inputs[f], &simulation, maxThreads);
+        simulation.simulationTime = simulation.startStep + options.steps;
+        Population *work = allocPopulation(simulation.numberOfPersons);
+
+        fprintf(stderr, "%s: %d persons, %d steps\n", options.inputs[f], simulation.numberOfPersons, options.steps);
+
+        CellIndex *grid = allocGrid(&simulation, 1, options.gridType);
+        TimingSummary serial = timeEngine(simulateSerial, grid, initial, work, &simulation, &options);
+        freeGrid(grid);
+        fprintf(output, "%s,%d,%d,serial,scalar,1,%d,%.6f,%.6f,%.6f,%.6f,%.4f,%.4f\n", options.inputs[f], simulation.numberOfPersons,
+                options.steps, options.repetitions, serial.median, serial.mean, serial.stddev, serial.min, 1.0, 1.0);
+        fflush(output);
+
+        for(int t=0;t<options.threadCountCount;t++) {
+            int threads = options.threadCounts[t];
+            omp_set_num_threads(threads);
+            grid = allocGrid(&simulation, threads, options.gridType);
+            TimingSummary parallel = timeEngine(parallelEngine, grid, initial, work, &simulation, &options);
+            freeGrid(grid);
+
+            double speedup = parallel.median > 0 ? serial.median / parallel.median : 0;
+            fprintf(output, "%s,%d,%d,%s,%s,%d,%d,%.6f,%.6f,%.6f,%.6f,%.4f,%.4f\n", options.inputs[f], simulation.numberOfPersons,
+                    options.steps, parallelName, kernels.name, threads, options.repetitions, parallel.median, parallel.mean,
+                    parallel.stddev, parallel.min, speedup, speedup / threads);
+            fflush(output);
+        }
+
+        freePopulation(work);
+        freePopulation(initial);
+    }
+
+    if(output != stdout) {
+        fclose(output);
+    }
+    return 0;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Time Engine
+ * Purpose:   Run engine options->warmup + options->repetitions times on a copy of initial and summarize the times of the last
+            options->repetitions runs; only the engine is timed, not the copy of the persons
+ * In args:   engine, grid, initial, work (population the runs are done on), simulation, options
+ */
+TimingSummary timeEngine(SimulationEngine engine, CellIndex *grid, Population *initial, Population *work, SimulationData *simulation,
+                         BenchmarkOptions *options) {
+    double *times = malloc(options->repetitions * sizeof(double));
+    if(!times) {
+        printf("Eroare la alocare\n");
+        exit(-1);
+    }
+
+    PersonOrder *order = options->reorderEvery >= 0 ? allocPersonOrder(simulation->numberOfPersons, options->reorderEvery, options->curve) : NULL;
+
+    for(int run=0;run<options->warmup + options->repetitions;run++) {
+        copyPopulation(work, initial, simulation->numberOfPersons);
+        initGrid(grid, work, simulation);
+
+        // reordonarile si refacerea ordinii initiale sunt masurate impreuna cu simularea
+        struct timespec start, finish;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        runEngine(engine, grid, work, simulation, NULL, order, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &finish);
+
+        if(run >= options->warmup) {
+            times[run - options->warmup] = elapsedSeconds(&start, &finish);
+        }
+    }
+
+    TimingSummary summary = summarizeTimes(times, options->repetitions);
+    free(times);
+    if(order) freePersonOrder(order);
+    return summary;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Summarize Times
+ * Purpose:   Median, mean, sample standard deviation and minimum of count times; times ends up sorted
+ * In args:   times, count
+ */
+TimingSummary summarizeTimes(double *times, int count) {
+    TimingSummary summary;
+    qsort(times, count, sizeof(double), compareTimes);
+
+    summary.min = times[0];
+    summary.median = count % 2 ? times[count / 2] : (times[count / 2 - 1] + times[count / 2]) / 2;
+
+    double sum = 0;
+    for(int k=0;k<count;k++) {
+        sum += times[k];
+    }
+    summary.mean = sum / count;
+
+    double squares = 0;
+    for(int k=0;k<count;k++) {
+        squares += (times[k] - summary.mean) * (times[k] - summary.mean);
+    }
+    summary.stddev = count > 1 ? sqrt(squares / (count - 1)) : 0;
+
+    return summary;
+}
+
+int compareTimes(const void *first, const void *second) {
+    double a = *(const double *)first, b = *(const double *)second;
+    return (a > b) - (a < b);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Benchmark Usage
+ * Purpose:   Show and explain usage of the benchmark and its command line arguments
+ */
+void benchmarkUsage() {
+    printf("Invalid arguments. Program call should be: ./bench [options] [inputFileName...]\n");
+    printf("Without input files the bundled epidemics10K/20K/50K/100K.txt are used; the CSV results go to stdout\n");
+    printf("Options:\n");
+    printf("  %sN                    measured runs of every engine (default %d)\n", REPETITIONS_OPTION, DEFAULT_REPETITIONS);
+    printf("  %sN                  runs before the measured ones (default %d)\n", WARMUP_OPTION, DEFAULT_WARMUP);
+    printf("  %sN                   steps simulated in every run (default %d)\n", STEPS_OPTION, DEFAULT_STEPS);
+    printf("  %sT1,T2,...         thread counts of the parallel engine (default 1, 2, 4, ... up to the number of processors)\n", THREADS_OPTION);
+    printf("  %sauto|scalar|avx2|avx512  kernels of the parallel engine (default auto)\n", KERNELS_OPTION);
+    printf("  %s                     measure the fused parallel engine\n", FUSED_OPTION);
+    printf("  %s                    measure the active set parallel engine\n", ACTIVE_OPTION);
+    printf("  %s                  measure the POSIX threads engine instead of the OpenMP one\n", PTHREADS_OPTION);
+    printf("  %sspin|pthread        barrier between the phases of the POSIX threads engine (default spin)\n", BARRIER_OPTION);
+    printf("  %s[=K]                 reorder the persons on a space filling curve every K steps (adaptive without K), in every engine\n",
+           REORDER_OPTION);
+    printf("  %smorton|hilbert         curve of %s (default morton)\n", CURVE_OPTION, REORDER_OPTION);
+    printf("  %sauto|dense|sparse      cell index of every engine (default auto)\n", GRID_OPTION);
+    printf("  %spath                write the CSV results to path\n", OUTPUT_OPTION);
+    exit(-1);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Parse Benchmark Options
+ * Purpose:   Read the options and the input files of the benchmark
+ * In args:   argc, argv
+ * Out args:  options
+ */
+void parseBenchmarkOptions(int argc, const char *argv[], BenchmarkOptions *options) {
+    options->repetitions = DEFAULT_REPETITIONS;
+    options->warmup = DEFAULT_WARMUP;
+    options->steps = DEFAULT_STEPS;
+    options->threadCountCount = 0;
+    options->fused = 0;
+    options->active = 0;
+    options->pthreads = 0;
+    options->barrierType = BARRIER_SPIN;
+    options->reorderEvery = -1;
+    options->curve = CURVE_MORTON;
+    options->kernelType = KERNELS_AUTO;
+    options->gridType = GRID_AUTO;
+    options->outputPath = NULL;
+    options->inputCount = 0;
+
+    for(int i=1;i<argc;i++) {
+        if(strncmp(argv[i], REPETITIONS_OPTION, strlen(REPETITIONS_OPTION)) == 0) {
+            options->repetitions = atoi(argv[i] + strlen(REPETITIONS_OPTION));
+            if(options->repetitions <= 0) benchmarkUsage();
+        } else if(strncmp(argv[i], WARMUP_OPTION, strlen(WARMUP_OPTION)) == 0) {
+            options->warmup = atoi(argv[i] + strlen(WARMUP_OPTION));
+            if(options->warmup < 0) benchmarkUsage();
+        } else if(strncmp(argv[i], STEPS_OPTION, strlen(STEPS_OPTION)) == 0) {
+            options->steps = atoi(argv[i] + strlen(STEPS_OPTION));
+            if(options->steps <= 0) benchmarkUsage();
+        } else if(strncmp(argv[i], THREADS_OPTION, strlen(THREADS_OPTION)) == 0) {
+            options->threadCountCount = parseThreadCounts(argv[i] + strlen(THREADS_OPTION), options->threadCounts);
+        } else if(strncmp(argv[i], KERNELS_OPTION, strlen(KERNELS_OPTION)) == 0) {
+            const char *name = argv[i] + strlen(KERNELS_OPTION);
+            if(strcmp(name, "auto") == 0) {
+                options->kernelType = KERNELS_AUTO;
+            } else if(strcmp(name, "scalar") == 0) {
+                options->kernelType = KERNELS_SCALAR;
+            } else if(strcmp(name, "avx2") == 0) {
+                options->kernelType = KERNELS_AVX2;
+            } else if(strcmp(name, "avx512") == 0) {
+                options->kernelType = KERNELS_AVX512;
+            } else {
+                benchmarkUsage();
+            }
+        } else if(strcmp(argv[i], FUSED_OPTION) == 0) {
+            options->fused = 1;
+        } else if(strcmp(argv[i], ACTIVE_OPTION) == 0) {
+            options->active = 1;
+        } else if(strcmp(argv[i], REORDER_OPTION) == 0) {
+            options->reorderEvery = 0;
+        } else if(strncmp(argv[i], REORDER_OPTION "=", strlen(REORDER_OPTION "=")) == 0) {
+            options->reorderEvery = atoi(argv[i] + strlen(REORDER_OPTION "="));
+            if(options->reorderEvery <= 0) benchmarkUsage();
+        } else if(strncmp(argv[i], CURVE_OPTION, strlen(CURVE_OPTION)) == 0) {
+            const char *curve = argv[i] + strlen(CURVE_OPTION);
+            if(strcmp(curve, "morton") == 0) {
+                options->curve = CURVE_MORTON;
+            } else if(strcmp(curve, "hilbert") == 0) {
+                options->curve = CURVE_HILBERT;
+            } else {
+                benchmarkUsage();
+            }
+        } else if(strcmp(argv[i], PTHREADS_OPTION) == 0) {
+            options->pthreads = 1;
+        } else if(strncmp(argv[i], BARRIER_OPTION, strlen(BARRIER_OPTION)) == 0) {
+            const char *type = argv[i] + strlen(BARRIER_OPTION);
+            if(strcmp(type, "spin") == 0) {
+                options->barrierType = BARRIER_SPIN;
+            } else if(strcmp(type, "pthread") == 0) {
+                options->barrierType = BARRIER_PTHREAD;
+            } else {
+                benchmarkUsage();
+            }
+        } else if(strncmp(argv[i], GRID_OPTION, strlen(GRID_OPTION)) == 0) {
+            const char *type = argv[i] + strlen(GRID_OPTION);
+            if(strcmp(type, "auto") == 0) {
+                options->gridType = GRID_AUTO;
+            } else if(strcmp(type, "dense") == 0) {
+                options->gridType = GRID_DENSE;
+            } else if(strcmp(type, "sparse") == 0) {
+                options->gridType = GRID_SPARSE;
+            } else {
+                benchmarkUsage();
+            }
+        } else if(strncmp(argv[i], OUTPUT_OPTION, strlen(OUTPUT_OPTION)) == 0) {
+            options->outputPath = argv[i] + strlen(OUTPUT_OPTION);
+        } else if(argv[i][0] == '-' || options->inputCount == MAX_BENCHMARK_INPUTS) {
+            benchmarkUsage();
+        } else {
+            options->inputs[options->inputCount++] = argv[i];
+        }
+    }
+
+    if(options->inputCount == 0) {
+        options->inputCount = sizeof(defaultInputs) / sizeof(defaultInputs[0]);
+        for(int f=0;f<options->inputCount;f++) {
+            options->inputs[f] = defaultInputs[f];
+        }
+    }
+
+    // implicit: puterile lui 2 pana la numarul de procesoare, plus numarul de procesoare
+    if(options->threadCountCount == 0) {
+        int processors = omp_get_num_procs();
+        for(int threads=1;threads<processors && options->threadCountCount < MAX_THREAD_COUNTS - 1;threads*=2) {
+            options->threadCounts[options->threadCountCount++] = threads;
+        }
+        options->threadCounts[options->threadCountCount++] = processors;
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Parse Thread Counts
+ * Purpose:   Read a comma separated list of positive thread counts
+ * In args:   list
+ * Out args:  threadCounts
+ * Return:    the number of thread counts read
+ */
+int parseThreadCounts(const char *list, int *threadCounts) {
+    int count = 0;
+    const char *cursor = list;
+
+    while(*cursor) {
+        char *end;
+        long threads = strtol(cursor, &end, 10);
+        if(end == cursor || threads <= 0 || threads > INT_MAX || count == MAX_THREAD_COUNTS || (*end != ',' && *end != '\0')) {
+            benchmarkUsage();
+        }
+        threadCounts[count++] = (int)threads;
+        cursor = *end == ',' ? end + 1 : end;
+    }
+
+    if(count == 0) {
+        benchmarkUsage();
+    }
+    return count;
+}
@@ -0,0 +1,654 @@
+/**
+ * Distributed (MPI) version of the epidemics simulation
+ * The grid is split in strips of whole rows (x) between the processes; every process keeps only the persons of its strip
+ * and runs the OpenMP engine on them. Infection only looks at the persons of one cell and a cell belongs to exactly one strip,
+ * so no halo of neighbouring cells is needed: after the location update every person that left the strip is sent
+ * to the process that owns its new row. The result is the same as the one of the serial version.
+ * Program call: mpirun -np P ./ex1_mpi simulationTime inputFileName threadNumber [--binary-output]
+ */
+
+#include <mpi.h>
+
+#include "epidemics.h"
+
+#define DISTRIBUTED_ARGUMENT_COUNT 4
+#define BINARY_OUTPUT_OPTION "--binary-output"
+#define DISTRIBUTED_PATH_SUFFIX "_distributed_out.txt"
+#define DISTRIBUTED_BINARY_PATH_SUFFIX "_distributed_out.bin"
+#define MIN_DOMAIN_CAPACITY 1024
+
+// o persoana trimisa intre procese; nextStatus nu e trimis, la sfarsitul pasului e egal cu status
+typedef struct {
+    int32_t personID;
+    int32_t index;              // pozitia persoanei in fisierul de intrare, dupa care e ordonata iesirea
+    int32_t x;
+    int32_t y;
+    int32_t movementAmplitude;
+    int32_t infectionCounter;
+    uint8_t status;
+    uint8_t statusDuration;
+    uint8_t movementDirection;
+    uint8_t padding;
+}PersonRecord;
+
+// partea din simulare a unui proces: persoanele din fasia de randuri [firstRow, firstRow + rowCount)
+typedef struct {
+    int rank;
+    int processCount;
+    int threadCount;
+    int firstRow;
+    int rowCount;
+    int count;                  // cate persoane are procesul acum
+    int capacity;               // pentru cate persoane sunt alocate population, index si grid
+    Population *population;
+    int *index;                 // pozitia fiecarei persoane in fisierul de intrare
+    CellIndex *grid;            // doar celulele fasiei
+}Domain;
+
+void distributedUsage(int rank);
+void abortAll(int rank);
+int stripStart(int rank, int processCount, int maxXCoord);
+int rowOwner(int x, int processCount, int maxXCoord);
+void initDomain(Domain *domain, SimulationData *simulation, int threadCount);
+void ensureCapacity(Domain *domain, SimulationData *simulation, int capacity);
+void packPerson(Domain *domain, int i, PersonRecord *record);
+void unpackPerson(Domain *domain, int i, const PersonRecord *record);
+void loadDomain(const char *path, Domain *domain, SimulationData *simulation);
+void scanDomainRows(InputFile *input, Domain *domain, SimulationData *simulation);
+void exchangePersons(Domain *domain, const int *destination, PersonRecord **received, int *receivedCount);
+void migratePersons(Domain *domain, SimulationData *simulation);
+void simulateDistributed(Domain *domain, SimulationData *simulation);
+Population *gatherOutputBlock(Domain *domain, SimulationData *simulation, int *blockStart, int *blockSize);
+void writeDistributedOutput(const char *path, Domain *domain, SimulationData *simulation, int format);
+
+int main(int argc, char *argv[]) {
+    int provided, rank, processCount;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &processCount);
+
+    if(argc < DISTRIBUTED_ARGUMENT_COUNT || argc > DISTRIBUTED_ARGUMENT_COUNT + 1) {
+        distributedUsage(rank);
+    }
+    int binaryOutput = 0;
+    if(argc == DISTRIBUTED_ARGUMENT_COUNT + 1) {
+        if(strcmp(argv[DISTRIBUTED_ARGUMENT_COUNT], BINARY_OUTPUT_OPTION) != 0) distributedUsage(rank);
+        binaryOutput = 1;
+    }
+    int threadNumber = atoi(argv[3]);
+    if(threadNumber <= 0) {
+        distributedUsage(rank);
+    }
+    omp_set_num_threads(threadNumber);
+    kernels = getKernels(KERNELS_AUTO);
+
+    const char *path = argv[2];
+    SimulationData simulation;
+    Domain domain;
+    domain.rank = rank;
+    domain.processCount = processCount;
+    domain.threadCount = threadNumber;
+    loadDomain(path, &domain, &simulation);
+    simulation.simulationTime = atoi(argv[1]);
+    if(simulation.simulationTime < simulation.startStep) {
+        if(rank == 0) printf("Snapshot-ul este la pasul %d, dupa simulationTime %d\n", simulation.startStep, simulation.simulationTime);
+        abortAll(rank);
+    }
+
+    if(rank == 0) {
+        printf("Measuring Distributed (%d processes x %d threads, %s kernels)...\n", processCount, threadNumber, kernels.name);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+
+    simulateDistributed(&domain, &simulation);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double time = MPI_Wtime() - start;
+    int minCount = domain.count, maxCount = domain.count;
+    MPI_Allreduce(MPI_IN_PLACE, &minCount, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, &maxCount, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if(rank == 0) {
+        printf("Time: %lf\n", time);
+        printf("Persons per process at the end: %d .. %d\n", minCount, maxCount);
+    }
+
+    char *outputPath = buildOutputPath(path, binaryOutput ? DISTRIBUTED_BINARY_PATH_SUFFIX : DISTRIBUTED_PATH_SUFFIX);
+    writeDistributedOutput(outputPath, &domain, &simulation, binaryOutput ? BINARY_SNAPSHOT_FORMAT : STANDARD_PRINT_FORMAT);
+    free(outputPath);
+
+    freePopulation(domain.population);
+    free(domain.index);
+    freeGrid(domain.grid);
+    MPI_Finalize();
+    return 0;
+}
+
+void distributedUsage(int rank) {
+    if(rank == 0) {
+        printf("Invalid arguments. Program call should be: mpirun -np P ./ex1_mpi simulationTime inputFileName threadNumber [%s]\n", BINARY_OUTPUT_OPTION);
+        printf("inputFileName can be a text input file or a binary snapshot; every process uses threadNumber OpenMP threads\n");
+        printf("The result is written to %s (or %s)\n", DISTRIBUTED_PATH_SUFFIX, DISTRIBUTED_BINARY_PATH_SUFFIX);
+    }
+    MPI_Finalize();
+    exit(-1);
+}
+
+// primul rand al fasiei procesului rank
+/*-----------------------------------------------------------------
+ * Function:  Abort All
+ * Purpose:   Stop all processes after an error found by all of them and printed only by process 0: the other processes wait
+            in a barrier that never ends, so their MPI_Abort cannot kill process 0 before its message is written
+ * In args:   rank
+ */
+void abortAll(int rank) {
+    fflush(stdout);
+    if(rank != 0) MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+}
+
+int stripStart(int rank, int processCount, int maxXCoord) {
+    return (int)((long long)rank * maxXCoord / processCount);
+}
+
+// procesul care are randul x
+int rowOwner(int x, int processCount, int maxXCoord) {
+    int rank = (int)((long long)x * processCount / maxXCoord);
+    while(rank + 1 < processCount && stripStart(rank + 1, processCount, maxXCoord) <= x) rank++;
+    while(rank > 0 && stripStart(rank, processCount, maxXCoord) > x) rank--;
+    return rank;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Init Domain
+ * Purpose:   Compute the strip of the process and allocate room for MIN_DOMAIN_CAPACITY persons
+ * In args:   domain (rank, processCount, threadCount), simulation
+ */
+void initDomain(Domain *domain, SimulationData *simulation, int threadCount) {
+    if(domain->processCount > simulation->maxXCoord) {
+        if(domain->rank == 0) printf("Grid-ul are %d randuri, prea putine pentru %d procese\n", simulation->maxXCoord, domain->processCount);
+        abortAll(domain->rank);
+    }
+    domain->threadCount = threadCount;
+    domain->firstRow = stripStart(domain->rank, domain->processCount, simulation->maxXCoord);
+    domain->rowCount = stripStart(domain->rank + 1, domain->processCount, simulation->maxXCoord) - domain->firstRow;
+    domain->count = 0;
+    domain->capacity = 0;
+    domain->population = NULL;
+    domain->index = NULL;
+    domain->grid = NULL;
+    ensureCapacity(domain, simulation, MIN_DOMAIN_CAPACITY);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Ensure Capacity
+ * Purpose:   Make room for at least capacity persons, doubling the arrays of the domain; the persons are kept,
+            the grid of the strip is allocated again for the new number of persons
+ * In args:   domain, simulation, capacity
+ */
+void ensureCapacity(Domain *domain, SimulationData *simulation, int capacity) {
+    if(capacity <= domain->capacity) return;
+    int newCapacity = domain->capacity > 0 ? domain->capacity : MIN_DOMAIN_CAPACITY;
+    while(newCapacity < capacity) newCapacity *= 2;
+
+    // doar procesul acesta a ramas fara memorie, ceilalti pot fi deja in MPI_Alltoallv: toate procesele sunt oprite imediat
+    Population *population = tryAllocPopulation(newCapacity);
+    int *index = malloc(newCapacity * sizeof(int));
+    if(!population || !index) {
+        printf("Procesul %d: eroare la alocare domeniu de %d persoane\n", domain->rank, newCapacity);
+        fflush(stdout);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if(domain->population) {
+        copyPopulation(population, domain->population, domain->count);
+        memcpy(index, domain->index, domain->count * sizeof(int));
+        freePopulation(domain->population);
+        free(domain->index);
+        freeGrid(domain->grid);
+    }
+
+    SimulationData strip = *simulation;
+    strip.maxXCoord = domain->rowCount;
+    strip.numberOfPersons = newCapacity;
+    char error[LOAD_ERROR_LENGTH];
+    domain->grid = tryAllocGrid(&strip, domain->threadCount, GRID_AUTO, error);
+    if(!domain->grid) {
+        printf("Procesul %d: %s\n", domain->rank, error);
+        fflush(stdout);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    domain->grid->firstRow = domain->firstRow;
+
+    domain->population = population;
+    domain->index = index;
+    domain->capacity = newCapacity;
+}
+
+void packPerson(Domain *domain, int i, PersonRecord *record) {
+    Population *population = domain->population;
+    record->personID = population->personID[i];
+    record->index = domain->index[i];
+    record->x = population->x[i];
+    record->y = population->y[i];
+    record->movementAmplitude = population->movementAmplitude[i];
+    record->infectionCounter = population->infectionCounter[i];
+    record->status = population->status[i];
+    record->statusDuration = population->statusDuration[i];
+    record->movementDirection = population->movementDirection[i];
+    record->padding = 0;
+}
+
+void unpackPerson(Domain *domain, int i, const PersonRecord *record) {
+    Population *population = domain->population;
+    population->personID[i] = record->personID;
+    domain->index[i] = record->index;
+    population->x[i] = record->x;
+    population->y[i] = record->y;
+    population->movementAmplitude[i] = record->movementAmplitude;
+    population->infectionCounter[i] = record->infectionCounter;
+    population->status[i] = record->status;
+    population->nextStatus[i] = record->status;
+    population->statusDuration[i] = record->statusDuration;
+    population->movementDirection[i] = record->movementDirection;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Load Domain
+ * Purpose:   Every process reads only its 1 / processCount part of the input (a byte range of the text file, or an index range
+            of the mapped snapshot) and then sends every person to the process of its row, so no process holds the whole population
+ * In args:   path, domain (rank, processCount, threadCount)
+ * Out args:  simulation, domain
+ */
+void loadDomain(const char *path, Domain *domain, SimulationData *simulation) {
+    InputFile input = openInputFile(path);
+
+    if(isSnapshot(&input)) {
+        Population *snapshot = loadSnapshot(&input, simulation);
+        initDomain(domain, simulation, domain->threadCount);
+        int first = (int)((long long)domain->rank * simulation->numberOfPersons / domain->processCount);
+        int last = (int)((long long)(domain->rank + 1) * simulation->numberOfPersons / domain->processCount);
+
+        ensureCapacity(domain, simulation, last - first);
+        Population *population = domain->population;
+        for(int i=first;i<last;i++) {
+            int k = i - first;
+            population->personID[k] = snapshot->personID[i];
+            population->x[k] = snapshot->x[i];
+            population->y[k] = snapshot->y[i];
+            population->status[k] = snapshot->status[i];
+            population->nextStatus[k] = snapshot->status[i];
+            population->statusDuration[k] = snapshot->statusDuration[i];
+            population->movementDirection[k] = snapshot->movementDirection[i];
+            population->movementAmplitude[k] = snapshot->movementAmplitude[i];
+            population->infectionCounter[k] = snapshot->infectionCounter[i];
+            domain->index[k] = i;
+        }
+        domain->count = last - first;
+        freePopulation(snapshot);
+    } else {
+        simulationScan(&input, simulation);
+        initDomain(domain, simulation, domain->threadCount);
+        scanDomainRows(&input, domain, simulation);
+    }
+    closeInputFile(&input);
+
+    migratePersons(domain, simulation);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Scan Domain Rows
+ * Purpose:   Parse the person rows of the byte range of the process (cut at line ends, like the threads of personScan do);
+            the index of the first row comes from the rows of the processes before it
+ * In args:   input, domain, simulation
+ */
+void scanDomainRows(InputFile *input, Domain *domain, SimulationData *simulation) {
+    const char *begin = input->data + input->position;
+    const char *end = input->data + input->size;
+    size_t size = end - begin;
+
+    const char *partStart = begin + size * domain->rank / domain->processCount;
+    const char *partEnd = begin + size * (domain->rank + 1) / domain->processCount;
+    if(domain->rank > 0) {
+        const char *newLine = memchr(partStart - 1, '\n', end - partStart + 1);
+        partStart = newLine ? newLine + 1 : end;
+    }
+    if(domain->rank < domain->processCount - 1) {
+        const char *newLine = memchr(partEnd - 1, '\n', end - partEnd + 1);
+        partEnd = newLine ? newLine + 1 : end;
+    } else {
+        partEnd = end;
+    }
+
+    // randurile nevide si liniile din partea procesului, pentru indexul primei persoane si numarul liniei in erori
+    int counts[2] = {0, 0};
+    for(const char *cursor=partStart;cursor<partEnd;counts[1]++) {
+        const char *newLine = memchr(cursor, '\n', partEnd - cursor);
+        const char *lineEnd = newLine ? newLine : partEnd;
+        while(cursor < lineEnd && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')) cursor++;
+        if(cursor < lineEnd) counts[0]++;
+        cursor = newLine ? newLine + 1 : partEnd;
+    }
+    int before[2] = {0, 0}, total = 0;
+    MPI_Exscan(counts, before, 2, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if(domain->rank == 0) before[0] = before[1] = 0;
+    MPI_Allreduce(&counts[0], &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if(total != simulation->numberOfPersons) {
+        if(domain->rank == 0) printf("Fisierul de intrare are %d randuri cu persoane, dar antetul anunta %d\n", total, simulation->numberOfPersons);
+        abortAll(domain->rank);
+    }
+
+    ensureCapacity(domain, simulation, counts[0]);
+    int line = input->line + before[1];
+    int values[PERSON_FIELD_COUNT];
+    char error[INPUT_ERROR_LENGTH];
+    for(const char *cursor=partStart;cursor<partEnd;line++) {
+        const char *nextLine;
+        int count = parseLine(cursor, partEnd, values, PERSON_FIELD_COUNT, &nextLine);
+        cursor = nextLine;
+        if(count == 0) continue;
+
+        if(count != PERSON_FIELD_COUNT) {
+            printf("Linia %d: rand invalid, se asteapta %d numere intregi\n", line, PERSON_FIELD_COUNT);
+            fflush(stdout);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        } else if(checkRow(values, simulation, error) != 0) {
+            printf("Linia %d: %s\n", line, error);
+            fflush(stdout);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        initPerson(domain->population, domain->count, values, simulation);
+        domain->index[domain->count] = before[0] + domain->count;
+        domain->count++;
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Exchange Persons
+ * Purpose:   Send every person i of the domain with destination[i] >= 0 to process destination[i] (one MPI_Alltoallv)
+ * In args:   domain, destination
+ * Out args:  received (allocated here), receivedCount
+ */
+void exchangePersons(Domain *domain, const int *destination, PersonRecord **received, int *receivedCount) {
+    int processCount = domain->processCount;
+    int *sendCounts = calloc(processCount, sizeof(int));
+    int *sendOffsets = malloc(processCount * sizeof(int));
+    int *receiveCounts = malloc(processCount * sizeof(int));
+    int *receiveOffsets = malloc(processCount * sizeof(int));
+    if(!sendCounts || !sendOffsets || !receiveCounts || !receiveOffsets) {
+        printf("Procesul %d: eroare la alocare pentru migrare\n", domain->rank);
+        fflush(stdout);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    int sendTotal = 0;
+    for(int i=0;i<domain->count;i++) {
+        if(destination[i] >= 0) {
+            sendCounts[destination[i]]++;
+            sendTotal++;
+        }
+    }
+    MPI_Alltoall(sendCounts, 1, MPI_INT, receiveCounts, 1, MPI_INT, MPI_COMM_WORLD);
+
+    int receiveTotal = 0;
+    for(int p=0;p<processCount;p++) {
+        sendOffsets[p] = p > 0 ? sendOffsets[p - 1] + sendCounts[p - 1] : 0;
+        receiveOffsets[p] = receiveTotal;
+        receiveTotal += receiveCounts[p];
+    }
+
+    PersonRecord *sendBuffer = malloc((sendTotal > 0 ? sendTotal : 1) * sizeof(PersonRecord));
+    *received = malloc((receiveTotal > 0 ? receiveTotal : 1) * sizeof(PersonRecord));
+    if(!sendBuffer || !*received) {
+        printf("Procesul %d: eroare la alocare pentru migrare\n", domain->rank);
+        fflush(stdout);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    int *cursor = malloc(processCount * sizeof(int));
+    memcpy(cursor, sendOffsets, processCount * sizeof(int));
+    for(int i=0;i<domain->count;i++) {
+        if(destination[i] >= 0) {
+            packPerson(domain, i, &sendBuffer[cursor[destination[i]]++]);
+        }
+    }
+
+    // numaratorile si offseturile in octeti, persoanele sunt trimise ca MPI_BYTE
+    for(int p=0;p<processCount;p++) {
+        sendCounts[p] *= sizeof(PersonRecord);
+        sendOffsets[p] *= sizeof(PersonRecord);
+        receiveCounts[p] *= sizeof(PersonRecord);
+        receiveOffsets[p] *= sizeof(PersonRecord);
+    }
+    MPI_Alltoallv(sendBuffer, sendCounts, sendOffsets, MPI_BYTE, *received, receiveCounts, receiveOffsets, MPI_BYTE, MPI_COMM_WORLD);
+    *receivedCount = receiveTotal;
+
+    free(cursor);
+    free(sendBuffer);
+    free(sendCounts);
+    free(sendOffsets);
+    free(receiveCounts);
+    free(receiveOffsets);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Migrate Persons
+ * Purpose:   Send the persons whose row is outside the strip to the processes that own their rows, then keep the ones that stayed
+            (in the same order) and append the ones received
+ * In args:   domain, simulation
+ */
+void migratePersons(Domain *domain, SimulationData *simulation) {
+    int *destination = malloc((domain->count > 0 ? domain->count : 1) * sizeof(int));
+    if(!destination) {
+        printf("Procesul %d: eroare la alocare pentru migrare\n", domain->rank);
+        fflush(stdout);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    int lastRow = domain->firstRow + domain->rowCount;
+    #pragma omp parallel for num_threads(domain->threadCount)
+    for(int i=0;i<domain->count;i++) {
+        int x = domain->population->x[i];
+        destination[i] = x >= domain->firstRow && x < lastRow ? -1 : rowOwner(x, domain->processCount, simulation->maxXCoord);
+    }
+
+    PersonRecord *received;
+    int receivedCount;
+    exchangePersons(domain, destination, &received, &receivedCount);
+
+    int kept = 0;
+    for(int i=0;i<domain->count;i++) {
+        if(destination[i] >= 0) continue;
+        if(kept != i) {
+            PersonRecord record;
+            packPerson(domain, i, &record);
+            unpackPerson(domain, kept, &record);
+        }
+        kept++;
+    }
+    domain->count = kept;
+
+    ensureCapacity(domain, simulation, kept + receivedCount);
+    for(int k=0;k<receivedCount;k++) {
+        unpackPerson(domain, domain->count++, &received[k]);
+    }
+
+    free(received);
+    free(destination);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Simulate Distributed
+ * Purpose:   The steps of simulateParallel on the persons of the strip, followed by the migration of the persons that left it
+ * In args:   domain, simulation
+ */
+void simulateDistributed(Domain *domain, SimulationData *simulation) {
+    for(int time=simulation->startStep;time<simulation->simulationTime;time++) {
+        // grid-ul e al fasiei, dar locatiile se actualizeaza pe tot grid-ul, deci maxXCoord ramane al simularii
+        SimulationData local = *simulation;
+        local.numberOfPersons = domain->count;
+        Population *population = domain->population;
+
+        updateGridParallel(domain->grid, population, &local);
+        StepStatistics step = {.step = time + 1};
+        computeNextStatusParallel(domain->grid, population, &local, &step);
+
+        #pragma omp parallel num_threads(domain->threadCount)
+        {
+            int first, last;
+            threadRange(local.numberOfPersons, KERNEL_BLOCK_SIZE, &first, &last);
+            kernels.updateStatus(population, first, last, &local);
+            kernels.updateLocation(population, first, last, &local);
+        }
+
+        migratePersons(domain, simulation);
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Gather Output Block
+ * Purpose:   Send every person to the process that writes its part of the output: process r writes the persons with input
+            positions [r * numberOfPersons / processCount, (r + 1) * numberOfPersons / processCount), in input order
+ * In args:   domain, simulation
+ * Out args:  blockStart, blockSize
+ * Return:    the persons of the block, in input order
+ */
+Population *gatherOutputBlock(Domain *domain, SimulationData *simulation, int *blockStart, int *blockSize) {
+    int n = simulation->numberOfPersons;
+    int *destination = malloc((domain->count > 0 ? domain->count : 1) * sizeof(int));
+    if(!destination) {
+        printf("Procesul %d: eroare la alocare pentru iesire\n", domain->rank);
+        fflush(stdout);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    for(int i=0;i<domain->count;i++) {
+        int rank = (int)((long long)domain->index[i] * domain->processCount / n);
+        while(rank + 1 < domain->processCount && (long long)(rank + 1) * n / domain->processCount <= domain->index[i]) rank++;
+        destination[i] = rank;
+    }
+
+    PersonRecord *received;
+    int receivedCount;
+    exchangePersons(domain, destination, &received, &receivedCount);
+    free(destination);
+
+    *blockStart = (int)((long long)domain->rank * n / domain->processCount);
+    *blockSize = (int)((long long)(domain->rank + 1) * n / domain->processCount) - *blockStart;
+    if(receivedCount != *blockSize) {
+        printf("Procesul %d a primit %d persoane pentru iesire in loc de %d\n", domain->rank, receivedCount, *blockSize);
+        fflush(stdout);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    Population *block = tryAllocPopulation(*blockSize > 0 ? *blockSize : 1);
+    if(!block) {
+        printf("Procesul %d: eroare la alocare pentru iesire\n", domain->rank);
+        fflush(stdout);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    for(int k=0;k<receivedCount;k++) {
+        PersonRecord *record = &received[k];
+        int i = record->index - *blockStart;
+        block->personID[i] = record->personID;
+        block->x[i] = record->x;
+        block->y[i] = record->y;
+        block->status[i] = record->status;
+        block->nextStatus[i] = record->status;
+        block->statusDuration[i] = record->statusDuration;
+        block->movementDirection[i] = record->movementDirection;
+        block->movementAmplitude[i] = record->movementAmplitude;
+        block->infectionCounter[i] = record->infectionCounter;
+    }
+    free(received);
+    return block;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Write Distributed Output
+ * Purpose:   Every process writes its block of the output directly at its offset in the file at path: for text the offsets
+            come from the lengths of the blocks before it (the block is formatted twice, to measure and to write),
+            for a snapshot every array of the block goes at its place in the layout of snapshotLayout
+ * In args:   path, domain, simulation, format
+ */
+void writeDistributedOutput(const char *path, Domain *domain, SimulationData *simulation, int format) {
+    int blockStart, blockSize;
+    Population *block = gatherOutputBlock(domain, simulation, &blockStart, &blockSize);
+
+    // procesul 0 creeaza fisierul gol, apoi toate scriu in el
+    if(domain->rank == 0) {
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0) {
+            printf("File not found!\n");
+            fflush(stdout);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        close(fd);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    int fd = open(path, O_WRONLY);
+    if(fd < 0) {
+        printf("File not found!\n");
+        fflush(stdout);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    if(format == BINARY_SNAPSHOT_FORMAT) {
+        size_t offsets[POPULATION_ARRAY_COUNT];
+        size_t size = snapshotLayout(simulation->numberOfPersons, offsets);
+        if(domain->rank == 0) {
+            SnapshotHeader header;
+            initSnapshotHeader(&header, simulation, simulation->simulationTime);
+            if(pwrite(fd, &header, sizeof(header), 0) != sizeof(header) || ftruncate(fd, size) != 0) {
+                perror("File could not be written\n");
+                fflush(stdout);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        }
+        void **arrays[POPULATION_ARRAY_COUNT];
+        populationArrays(block, arrays);
+        for(int k=0;k<POPULATION_ARRAY_COUNT;k++) {
+            size_t length = (size_t)blockSize * populationElementSize[k];
+            if(length > 0 && pwrite(fd, *arrays[k], length, offsets[k] + (size_t)blockStart * populationElementSize[k]) != (ssize_t)length) {
+                perror("File could not be written\n");
+                fflush(stdout);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        }
+    } else {
+        char *buffer = malloc((size_t)OUTPUT_CHUNK_PERSONS * MAX_LINE_LENGTH);
+        if(!buffer) {
+            printf("Procesul %d: eroare la alocare buffer de iesire\n", domain->rank);
+            fflush(stdout);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+
+        long long length = 0;
+        for(int first=0;first<blockSize;first+=OUTPUT_CHUNK_PERSONS) {
+            int last = first + OUTPUT_CHUNK_PERSONS < blockSize ? first + OUTPUT_CHUNK_PERSONS : blockSize;
+            char *cursor = buffer;
+            for(int i=first;i<last;i++) cursor = formatPerson(cursor, block, i, format);
+            length += cursor - buffer;
+        }
+        long long offset = 0;
+        MPI_Exscan(&length, &offset, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+        if(domain->rank == 0) offset = 0;
+
+        for(int first=0;first<blockSize;first+=OUTPUT_CHUNK_PERSONS) {
+            int last = first + OUTPUT_CHUNK_PERSONS < blockSize ? first + OUTPUT_CHUNK_PERSONS : blockSize;
+            char *cursor = buffer;
+            for(int i=first;i<last;i++) cursor = formatPerson(cursor, block, i, format);
+            if(pwrite(fd, buffer, cursor - buffer, offset) != cursor - buffer) {
+                perror("File could not be written\n");
+                fflush(stdout);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            offset += cursor - buffer;
+        }
+        free(buffer);
+    }
+
+    if(close(fd) != 0) {
+        perror("File could not be closed\n");
+        fflush(stdout);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    freePopulation(block);
+    MPI_Barrier(MPI_COMM_WORLD);
+}
@@ -0,0 +1,208 @@
+#include "epidemics.h"
+
+/*-----------------------------------------------------------------
+ * Function:  Alloc Ensemble
+ * Purpose:   Build the bit sliced state of scenarioCount scenarios from the population: scenario 0 (bit 0 of every word) starts
+            exactly like the population, in the other ones every person that is not immune is infected with probability
+            infectedFraction, drawn from seed, the scenario and the person index; the duration of every scenario is kept
+            on planes bits, one word per bit
+ * In args:   population, simulation, scenarioCount (1 .. ENSEMBLE_MAX_SCENARIOS), infectedFraction, seed
+ */
+Ensemble *allocEnsemble(Population *population, SimulationData *simulation, int scenarioCount, double infectedFraction, uint64_t seed) {
+    int n = simulation->numberOfPersons;
+    Ensemble *ensemble = malloc(sizeof(Ensemble));
+    if(!ensemble) {
+        printf("Eroare la alocare ansamblu\n");
+        exit(-1);
+    }
+
+    int longest = simulation->infectedDuration > simulation->immuneDuration ? simulation->infectedDuration : simulation->immuneDuration;
+    ensemble->planes = 1;
+    while((longest >> ensemble->planes) != 0) ensemble->planes++;
+    ensemble->scenarioCount = scenarioCount;
+    ensemble->scenarioMask = scenarioCount == ENSEMBLE_MAX_SCENARIOS ? ~0ULL : (1ULL << scenarioCount) - 1;
+    ensemble->infected = alignedArray(n, sizeof(uint64_t));
+    ensemble->immune = alignedArray(n, sizeof(uint64_t));
+    ensemble->duration = alignedArray((size_t)n * ensemble->planes, sizeof(uint64_t));
+    ensemble->infectionCounter = alignedArray((size_t)n * ENSEMBLE_MAX_SCENARIOS, sizeof(int));
+
+    // prag pe 53 de biti pentru numerele aleatoare ale scenariilor 1..
+    uint64_t threshold = (uint64_t)(infectedFraction * (double)(1ULL << 53));
+
+    #pragma omp parallel for schedule(static)
+    for(int p=0;p<n;p++) {
+        int *counter = ensemble->infectionCounter + (size_t)p * ENSEMBLE_MAX_SCENARIOS;
+        uint64_t *duration = ensemble->duration + (size_t)p * ensemble->planes;
+        uint64_t infected = 0, immune = 0;
+        for(int b=0;b<ensemble->planes;b++) duration[b] = 0;
+
+        for(int s=0;s<ENSEMBLE_MAX_SCENARIOS;s++) {
+            int status = SUSCEPTIBLE, statusDuration = 0;
+            counter[s] = 0;
+            if(s == 0 || population->status[p] == IMMUNE) {
+                status = population->status[p];
+                statusDuration = population->statusDuration[p];
+                counter[s] = population->infectionCounter[p];
+            } else if(s < scenarioCount && (ensembleRandom(seed, s, p) >> 11) < threshold) {
+                // ca initPerson: durata intreaga de infectat si o infectare
+                status = INFECTED;
+                statusDuration = simulation->infectedDuration;
+                counter[s] = 1;
+            }
+
+            uint64_t bit = 1ULL << s;
+            if(status == INFECTED) infected |= bit;
+            if(status == IMMUNE) immune |= bit;
+            for(int b=0;b<ensemble->planes;b++) {
+                if((statusDuration >> b) & 1) duration[b] |= bit;
+            }
+        }
+        ensemble->infected[p] = infected & ensemble->scenarioMask;
+        ensemble->immune[p] = immune & ensemble->scenarioMask;
+        for(int b=0;b<ensemble->planes;b++) duration[b] &= ensemble->scenarioMask;
+    }
+
+    return ensemble;
+}
+
+void freeEnsemble(Ensemble *ensemble) {
+    free(ensemble->infected);
+    free(ensemble->immune);
+    free(ensemble->duration);
+    free(ensemble->infectionCounter);
+    free(ensemble);
+}
+
+// numar aleator pe 64 de biti (splitmix64) pentru persoana index din scenariul scenario
+uint64_t ensembleRandom(uint64_t seed, int scenario, int index) {
+    uint64_t value = seed + 0x9E3779B97F4A7C15ULL * ((uint64_t)scenario << 32 | (uint32_t)index);
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Simulate Ensemble
+ * Purpose:   Simulate all the scenarios of the ensemble at once: the movement does not depend on the status, so the grid and
+            the location updates are done once for all of them, on the coordinates of population; in every cell the words of
+            the infected persons are ORed, and every person of the cell goes to its next status in all scenarios with
+            bitwise operations (ensemblePerson); the results of every scenario are the same as simulateParallel would give
+ * In args:   grid, population, ensemble, simulation
+ */
+void simulateEnsemble(CellIndex *grid, Population *population, Ensemble *ensemble, SimulationData *simulation) {
+    for(int time=simulation->startStep;time<simulation->simulationTime;time++) {
+        updateGridParallel(grid, population, simulation);
+
+        int chunk = grid->occupiedCount / (grid->threadCount * INFECTION_CHUNKS_PER_THREAD);
+        if(chunk < 1) chunk = 1;
+
+        #pragma omp parallel num_threads(grid->threadCount)
+        {
+            // o persoana e intr-o singura celula, deci starea ei e citita si scrisa doar de thread-ul celulei
+            #pragma omp for schedule(dynamic, chunk)
+            for(int k=0;k<grid->occupiedCount;k++) {
+                int c = grid->occupiedCells[k];
+                const int *cellPersons = &grid->personIndex[grid->cellStart[c]];
+                int cellSize = grid->cellStart[c + 1] - grid->cellStart[c];
+
+                uint64_t cellInfected = 0;
+                for(int i=0;i<cellSize;i++) {
+                    cellInfected |= ensemble->infected[cellPersons[i]];
+                }
+                for(int i=0;i<cellSize;i++) {
+                    ensemblePerson(ensemble, cellPersons[i], cellInfected, simulation);
+                }
+            }
+
+            int first, last;
+            threadRange(simulation->numberOfPersons, KERNEL_BLOCK_SIZE, &first, &last);
+            kernels.updateLocation(population, first, last, simulation);
+        }
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Ensemble Person
+ * Purpose:   computeCellNextStatus and updateStatus of the person at index, in all scenarios: the susceptible ones in a cell with an
+            infected person become infected (duration infectedDuration - 1, one more infection), the infected and immune ones with
+            duration 0 become immune (duration immuneDuration) and susceptible, the others count down their duration, which is
+            decremented on the bit planes with a borrow
+ * In args:   ensemble, index, cellInfected (OR of the infected words of the cell), simulation
+ */
+void ensemblePerson(Ensemble *ensemble, int index, uint64_t cellInfected, SimulationData *simulation) {
+    uint64_t infected = ensemble->infected[index];
+    uint64_t immune = ensemble->immune[index];
+    uint64_t *duration = ensemble->duration + (size_t)index * ensemble->planes;
+    int planes = ensemble->planes;
+
+    uint64_t nonZero = 0;
+    for(int b=0;b<planes;b++) nonZero |= duration[b];
+    uint64_t expired = ~nonZero;
+    uint64_t newInfected = ~(infected | immune) & cellInfected & ensemble->scenarioMask;
+    uint64_t becomeImmune = infected & expired;
+
+    uint64_t borrow = (infected | immune) & nonZero;
+    uint64_t reset = newInfected | becomeImmune;
+    int infectedDuration = simulation->infectedDuration - 1;
+    int immuneDuration = simulation->immuneDuration;
+    for(int b=0;b<planes;b++) {
+        uint64_t bit = duration[b];
+        uint64_t value = bit ^ borrow;
+        borrow &= ~bit;
+        value &= ~reset;
+        if((infectedDuration >> b) & 1) value |= newInfected;
+        if((immuneDuration >> b) & 1) value |= becomeImmune;
+        duration[b] = value;
+    }
+
+    ensemble->infected[index] = (infected & nonZero) | newInfected;
+    ensemble->immune[index] = (immune & nonZero) | becomeImmune;
+
+    int *counter = ensemble->infectionCounter + (size_t)index * ENSEMBLE_MAX_SCENARIOS;
+    while(newInfected) {
+        counter[__builtin_ctzll(newInfected)]++;
+        newInfected &= newInfected - 1;
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Extract Scenario
+ * Purpose:   Write the status, duration and infections of one scenario in the arrays of population, to be written like a simulation
+ * In args:   ensemble, scenario, simulation
+ * Out args:  population
+ */
+void extractScenario(Ensemble *ensemble, int scenario, Population *population, SimulationData *simulation) {
+    #pragma omp parallel for schedule(static)
+    for(int p=0;p<simulation->numberOfPersons;p++) {
+        int status = (ensemble->infected[p] >> scenario) & 1 ? INFECTED : (ensemble->immune[p] >> scenario) & 1 ? IMMUNE : SUSCEPTIBLE;
+        int statusDuration = 0;
+        for(int b=0;b<ensemble->planes;b++) {
+            statusDuration |= (int)((ensemble->duration[(size_t)p * ensemble->planes + b] >> scenario) & 1) << b;
+        }
+        population->status[p] = status;
+        population->nextStatus[p] = status;
+        population->statusDuration[p] = statusDuration;
+        population->infectionCounter[p] = ensemble->infectionCounter[(size_t)p * ENSEMBLE_MAX_SCENARIOS + scenario];
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Ensemble Counts
+ * Purpose:   Count the infected and immune persons and the infections of every scenario
+ * In args:   ensemble, n
+ * Out args:  infected, immune, infections (ENSEMBLE_MAX_SCENARIOS each)
+ */
+void ensembleCounts(Ensemble *ensemble, int n, int *infected, int *immune, long long *infections) {
+    for(int s=0;s<ENSEMBLE_MAX_SCENARIOS;s++) {
+        infected[s] = 0;
+        immune[s] = 0;
+        infections[s] = 0;
+    }
+
+    for(int p=0;p<n;p++) {
+        for(uint64_t word=ensemble->infected[p];word;word&=word-1) infected[__builtin_ctzll(word)]++;
+        for(uint64_t word=ensemble->immune[p];word;word&=word-1) immune[__builtin_ctzll(word)]++;
+        const int *counter = ensemble->infectionCounter + (size_t)p * ENSEMBLE_MAX_SCENARIOS;
+        for(int s=0;s<ensemble->scenarioCount;s++) infections[s] += counter[s];
+    }
+}
@@ -0,0 +1,616 @@
+#ifndef EPIDEMICS_H
+#define EPIDEMICS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <omp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <signal.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS
+#endif
+
+#define INFECTED_DURATION 4
+#define IMMUNE_DURATION 2
+
+#define CACHE_LINE_SIZE 64
+#define SNAPSHOT_ALIGNMENT 64
+#define OUTPUT_CHUNK_PERSONS 16384 // cate persoane formateaza un thread intr-un buffer inainte de scriere
+#define MAX_LINE_LENGTH 128 // cel mai lung rand de iesire: STANDARD_PRINT_FORMAT cu 8 numere de cate 11 caractere
+#define PERSON_FIELD_COUNT 6 // personID x y status movementDirection movementAmplitude
+#define POPULATION_ARRAY_COUNT 9 // cate array-uri are Population
+#define INPUT_ERROR_LENGTH 160
+#define LOAD_ERROR_LENGTH 256 // mesajul unei erori intoarse de functiile try... (o linie, fara '\n')
+#define KERNEL_BLOCK_SIZE 64 // persoanele sunt impartite intre thread-uri in blocuri de atatea persoane, ca fiecare thread sa inceapa aliniat
+#define KERNEL_CHECK_PERSONS 4133
+#define FUSED_BLOCK_SIZE 512 // persoanele trecute prin status, locatie si numarare cat timp sunt inca in cache
+#define INFECTION_CHUNKS_PER_THREAD 16 // pasul de infectare imparte celulele ocupate in atatea bucati pe thread
+#define PROFILE_MAX_EVENTS 65536 // cate faze pastreaza un thread pentru trace
+#define STATISTICS_BUFFER_STEPS 1024 // cati pasi de statistici sunt tinuti in memorie inainte de scriere
+#define SPARSE_CELLS_PER_PERSON 4 // peste atatea celule pe persoana, GRID_AUTO alege indexul rar (doar celulele ocupate)
+#define SPARSE_RADIX_BITS 11 // bitii din cheia celulei sortati la o trecere a sortarii radix
+#define SPARSE_RADIX_BUCKETS (1 << SPARSE_RADIX_BITS)
+#define REORDER_PROBE_STEPS 8 // reordonarea adaptiva masoara pasii in segmente de atatia pasi
+#define ENSEMBLE_MAX_SCENARIOS 64 // scenariile unui ansamblu sunt bitii unui cuvant de 64 de biti
+#define FAST_FORWARD_CHECK_STEPS 64 // fastForward verifica la atatia pasi daca mai sunt persoane infectate sau imune
+#define BARRIER_SPINS_BEFORE_YIELD 256 // de cate ori verifica un thread bariera cu spin inainte de sched_yield
+#define SERVER_MAX_CLIENTS 16 // cati clienti pot fi conectati la server in acelasi timp
+#define SERVER_MAX_POPULATIONS 64 // cate populatii tine serverul in memorie
+#define SERVER_LINE_LENGTH 4096 // cea mai lunga comanda a unui client
+#define ACTIVE_TABLE_MIN_SIZE 64 // cea mai mica tabela de celule infectate a motorului activ (putere a lui 2)
+#define EMPTY_CELL_KEY UINT64_MAX
+
+#define SERIAL_PATH_SUFFIX "_serial_out.txt"
+#define PARALLEL_PATH_SUFFIX "_parallel_out.txt"
+#define SERIAL_BINARY_PATH_SUFFIX "_serial_out.bin"
+#define PARALLEL_BINARY_PATH_SUFFIX "_parallel_out.bin"
+#define SERIAL_CHECKPOINT_SUFFIX "_serial_checkpoint.bin"
+#define PARALLEL_CHECKPOINT_SUFFIX "_parallel_checkpoint.bin"
+#define TEMPORARY_SUFFIX ".tmp"
+#define SERIAL_STATISTICS_SUFFIX "_serial_stats.csv"
+#define PARALLEL_STATISTICS_SUFFIX "_parallel_stats.csv"
+#define SERIAL_BINARY_STATISTICS_SUFFIX "_serial_stats.bin"
+#define PARALLEL_BINARY_STATISTICS_SUFFIX "_parallel_stats.bin"
+
+#define SNAPSHOT_MAGIC "EPIDSNAP"
+#define SNAPSHOT_VERSION 1
+#define BINARY_EXTENSION ".bin"
+#define STATISTICS_MAGIC "EPIDSTAT"
+#define STATISTICS_VERSION 1
+#define STATISTICS_CSV_HEADER "step,infected,susceptible,immune,new_infections,occupied_cells,max_cell_occupancy\n"
+
+// #define DEBUG
+// #define DEBUG_GRID
+// #define PROFILE_PHASES // masoara fazele fiecarui pas pe fiecare thread (profile.c); fara el macro-urile PROFILE_ nu genereaza cod
+// #define WIDE_COORDINATES // coordonate pe 32 de biti, pentru grid-uri mai mari de 65535 pe o axa
+
+#ifdef WIDE_COORDINATES
+typedef int32_t coord_t;
+#define MAX_GRID_SIZE INT32_MAX
+#else
+typedef uint16_t coord_t;
+#define MAX_GRID_SIZE UINT16_MAX
+#endif
+
+_Static_assert(INFECTED_DURATION <= UINT8_MAX && IMMUNE_DURATION <= UINT8_MAX, "statusDuration is stored on 8 bits");
+
+typedef struct {
+    int maxXCoord;
+    int maxYCoord;
+    int numberOfPersons;
+    int simulationTime;
+    int startStep;          // pasul de la care porneste simularea (0, sau pasul unui snapshot binar)
+    int infectedDuration;   // cati pasi ramane infectata o persoana (INFECTED_DURATION daca nu e dat altfel)
+    int immuneDuration;     // cati pasi ramane imuna (IMMUNE_DURATION)
+}SimulationData;
+
+// structure of arrays: fiecare camp al persoanelor e un array separat, indexat cu indexul persoanei,
+// ca fiecare etapa a simularii sa citeasca doar campurile de care are nevoie
+typedef struct {
+    int *personID;
+    coord_t *x;
+    coord_t *y;
+    uint8_t *status;
+    uint8_t *nextStatus;
+    uint8_t *statusDuration;
+    uint8_t *movementDirection;
+    coord_t *movementAmplitude;
+    int *infectionCounter;
+    void *mapping;          // daca nu e NULL, array-urile sunt in acest snapshot mapat in memorie, nu alocate separat
+    size_t mappingSize;
+}Population;
+
+// antetul unui snapshot binar (little-endian), urmat de array-urile din Population in ordinea din populationArrays,
+// fiecare aliniat la SNAPSHOT_ALIGNMENT octeti fata de inceputul fisierului, ca sa poata fi folosite direct din mmap
+typedef struct {
+    char magic[8];          // SNAPSHOT_MAGIC, fara '\0'
+    uint32_t version;       // SNAPSHOT_VERSION
+    uint32_t headerSize;    // sizeof(SnapshotHeader)
+    int32_t maxXCoord;
+    int32_t maxYCoord;
+    int32_t numberOfPersons;
+    int32_t step;           // pasul simularii la care a fost scris
+    uint32_t coordSize;     // sizeof(coord_t) al programului care l-a scris
+    uint32_t reserved[7];
+}SnapshotHeader;
+
+_Static_assert(sizeof(SnapshotHeader) == 64, "snapshot header must be 64 bytes");
+_Static_assert(sizeof(int) == 4, "personID and infectionCounter are stored on 32 bits");
+
+// statisticile unui pas, adunate in pasul de infectare; un rand din fisierul de statistici (little-endian in cel binar)
+typedef struct {
+    int32_t step;               // pasul dupa care e starea numarata (1 = dupa primul pas)
+    int32_t infected;           // cate persoane au fiecare status dupa pas
+    int32_t susceptible;
+    int32_t immune;
+    int32_t newInfections;      // persoane susceptibile infectate la acest pas
+    int32_t occupiedCells;      // celule cu cel putin o persoana la pasul de infectare (-1 la simulateParallelActive, care nu le numara)
+    int32_t maxCellOccupancy;   // cele mai multe persoane dintr-o celula (-1 la simulateParallelActive)
+    int32_t reserved;
+}StepStatistics;
+
+// antetul fisierului binar de statistici, urmat de cate un StepStatistics pentru fiecare pas
+typedef struct {
+    char magic[8];          // STATISTICS_MAGIC, fara '\0'
+    uint32_t version;       // STATISTICS_VERSION
+    uint32_t headerSize;    // sizeof(StatisticsHeader)
+    uint32_t recordSize;    // sizeof(StepStatistics)
+    int32_t maxXCoord;
+    int32_t maxYCoord;
+    int32_t numberOfPersons;
+}StatisticsHeader;
+
+_Static_assert(sizeof(StepStatistics) == 32, "statistics record must be 32 bytes");
+_Static_assert(sizeof(StatisticsHeader) == 32, "statistics header must be 32 bytes");
+
+typedef enum {
+    STATISTICS_NONE,
+    STATISTICS_CSV,
+    STATISTICS_BINARY
+}StatisticsFormats;
+
+// fisierul in care o simulare isi scrie statisticile; pasii sunt stransi in steps si scrisi cate STATISTICS_BUFFER_STEPS odata
+typedef struct {
+    int fd;
+    int format;
+    int stepCount;
+    StepStatistics *steps;
+    char *text;             // buffer-ul in care sunt formatate randurile CSV
+    int keepErrors;         // 1: o scriere esuata e pastrata in writeError (tryStreamStatistics), 0: opreste programul
+    int writeError;         // errno al primei scrieri esuate, 0 daca nu a esuat niciuna
+}StatisticsStream;
+
+typedef enum {
+    GRID_AUTO,              // GRID_SPARSE daca grid-ul are mai mult de SPARSE_CELLS_PER_PERSON celule pe persoana
+    GRID_DENSE,
+    GRID_SPARSE
+}GridTypes;
+
+// persoanele active (infectate sau imune) ale lui simulateParallelActive si celulele in care sunt persoane infectate;
+// susceptibilii care nu se infecteaza nu au nimic de facut la un pas in afara de mutare, deci nu sunt in liste
+typedef struct {
+    int count;              // cate persoane active sunt in persons
+    int infectedCount;      // cate dintre ele sunt infectate
+    int *persons;           // indicii persoanelor active, apoi la fiecare pas si ai celor nou infectate
+    int *scratch;           // n pozitii: fiecare thread scrie in blocul lui persoanele gasite, inainte de a le muta in persons
+    int *threadFound;       // cate persoane a gasit fiecare thread
+    int tableBits;          // tabela de la pasul curent are 1 << tableBits pozitii
+    uint64_t *cellKeys;     // tabela hash (adresare deschisa) cu cheile x * maxYCoord + y ale celulelor cu persoane infectate
+}ActiveSet;
+
+// indexul persoanelor pe celule, refacut la fiecare pas; dens: un offset pentru fiecare celula a grid-ului,
+// rar: persoanele sortate dupa cheia celulei, cu un offset doar pentru fiecare celula ocupata, deci memoria depinde de persoane, nu de arie
+typedef struct {
+    int cellCount;          // dens: randurile grid-ului * maxYCoord, celula (x, y) are id-ul (x - firstRow) * maxYCoord + y;
+                            // rar: numarul de celule ocupate la pasul curent, numerotate in ordinea cheilor
+    int firstRow;           // primul x din grid: 0, sau inceputul fasiei unui proces in versiunea distribuita
+    int sparse;
+    int keyPasses;          // rar: trecerile sortarii radix, cate SPARSE_RADIX_BITS din cheie
+    int threadCount;        // cate histograme are threadCellCount
+    int *cellStart;         // cellCount + 1 offseturi: persoanele din celula c sunt personIndex[cellStart[c]] .. personIndex[cellStart[c + 1] - 1]
+    int *personIndex;       // indicii tuturor persoanelor, grupati pe celule
+    int *personCell;        // celula fiecarei persoane la pasul curent
+    int *cellCursor;        // pozitia urmatoarei scrieri din fiecare celula (varianta seriala)
+    int *threadCellCount;   // threadCount x cellCount histograme (varianta paralela); rar: threadCount x SPARSE_RADIX_BUCKETS
+    int occupiedCount;      // numarul de celule cu cel putin o persoana (varianta paralela)
+    int *occupiedCells;     // id-urile acestor celule, in ordine crescatoare
+    uint64_t *personKey;    // rar: cheia (x - firstRow) * maxYCoord + y a fiecarei persoane, apoi cheile sortate
+    uint64_t *keyBuffer;    // rar: al doilea buffer al sortarii, pentru chei si indicii persoanelor
+    int *indexBuffer;
+    ActiveSet *active;      // starea lui simulateParallelActive, alocata la prima rulare
+    struct PthreadsTeam *team;  // thread-urile lui simulatePthreads, pornite la prima rulare si oprite de freeGrid
+}CellIndex;
+
+typedef enum {
+    INFECTED,
+    SUSCEPTIBLE,
+    IMMUNE
+}Status;
+
+typedef enum {
+    NORTH,  //00
+    SOUTH,  //01
+    EAST,   //10
+    WEST    //11 ^ 0x0001 = 10
+}Directions;
+
+typedef enum {
+    STANDARD_PRINT_FORMAT,
+    ONLY_NUMBERS_PRINT_FORMAT,
+    INPUT_PRINT_FORMAT,         // formatul fisierelor de intrare (antet + "id x y status directie amplitudine")
+    BINARY_SNAPSHOT_FORMAT
+}PrintFormats;
+
+// fisierul de intrare mapat in memorie; position e inceputul randurilor cu persoane, dupa antet
+typedef struct {
+    const char *data;
+    size_t size;
+    size_t position;
+    int line;
+}InputFile;
+
+// prima eroare gasita de un thread la citire si cate randuri gresite a gasit in total
+typedef struct {
+    int errorCount;
+    int firstErrorLine;
+    char firstError[INPUT_ERROR_LENGTH];
+}InputErrors;
+
+// fazele unui pas, masurate cu PROFILE_PHASES
+typedef enum {
+    PHASE_GRID,
+    PHASE_INFECTION,
+    PHASE_STATUS,
+    PHASE_LOCATION,
+    PHASE_COUNT
+}Phases;
+
+#ifdef PROFILE_PHASES
+#define PROFILE_START(phase) profileStart(phase)
+#define PROFILE_STOP(phase, items) profileStop(phase, items)
+#define PROFILE_ALLOCATION() profileAllocation()
+#else
+#define PROFILE_START(phase)
+#define PROFILE_STOP(phase, items)
+#define PROFILE_ALLOCATION()
+#endif
+
+typedef enum {
+    KERNELS_AUTO,
+    KERNELS_SCALAR,
+    KERNELS_AVX2,
+    KERNELS_AVX512
+}KernelTypes;
+
+// implementarile pentru updateStatus si updateLocation pe un interval de persoane [first, last)
+typedef struct {
+    const char *name;
+    void (*updateStatus)(Population *population, int first, int last, SimulationData *simulation);
+    void (*updateLocation)(Population *population, int first, int last, SimulationData *simulation);
+}UpdateKernels;
+
+typedef void (*SimulationEngine)(CellIndex *grid, Population *population, SimulationData *simulation, StatisticsStream *statistics);
+
+// asteapta toate thread-urile unei echipe (OpenMP sau pthreads), pentru fazele scrise o singura data pentru amandoua
+typedef void (*BarrierFunction)(void *barrier);
+
+typedef enum {
+    BARRIER_SPIN,           // spin pe un sens care se inverseaza la fiecare trecere, cu sched_yield dupa BARRIER_SPINS_BEFORE_YIELD
+    BARRIER_PTHREAD         // pthread_barrier_t
+}BarrierTypes;
+
+// bariera dintre fazele lui simulatePthreads
+typedef struct {
+    int type;
+    int threadCount;
+    pthread_barrier_t barrier;
+    atomic_int waiting;     // spin: cate thread-uri au ajuns la bariera
+    atomic_int sense;       // spin: ultimul thread care ajunge il inverseaza si ii elibereaza pe ceilalti
+}PhaseBarrier;
+
+// un thread al lui simulatePthreads; fiecare e pe liniile lui de cache, ca rezultatele scrise de thread-uri sa nu se incurce
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) struct PthreadsTeam *team;
+    int thread;
+    int sense;              // sensul local pentru bariera cu spin
+    int first;              // persoanele thread-ului [first, last), aceleasi la toate fazele si toti pasii
+    int last;
+    int blockPersons;       // cate persoane si celule ocupate are blocul de celule al thread-ului la pasul curent
+    int blockOccupied;
+    StepStatistics step;    // statisticile celulelor infectate de thread la pasul curent
+    pthread_t handle;
+}PthreadsWorker;
+
+// thread-urile lui simulatePthreads, pastrate cat traieste grid-ul; intre rulari asteapta pe start (fara spin),
+// o rulare noua e anuntata marind generation sub lock
+typedef struct PthreadsTeam {
+    CellIndex *grid;
+    Population *population;     // ale rularii curente
+    SimulationData *simulation;
+    StatisticsStream *statistics;
+    PhaseBarrier barrier;
+    PthreadsWorker *workers;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    long long generation;       // cate rulari au fost pornite
+    int stop;                   // 1 cand freeGrid opreste thread-urile
+    int started;                // thread-urile 1 .. started - 1 au fost pornite si trebuie asteptate la oprire
+}PthreadsTeam;
+
+typedef enum {
+    CURVE_MORTON,           // bitii lui x si y intercalati
+    CURVE_HILBERT
+}CurveTypes;
+
+// reordonarea periodica a persoanelor dupa pozitia celulei lor pe o curba care umple spatiul, ca persoanele din aceeasi celula
+// sau din celule vecine sa fie apropiate in array-uri; order retine indexul initial al fiecarei pozitii
+typedef struct {
+    int every;              // din cati in cati pasi sunt reordonate; 0 = adaptiv
+    int curve;
+    int numberOfPersons;
+    int threadCount;
+    int ordered;            // persoanele nu sunt in ordinea initiala
+    int swapped;            // populatia are array-urile lui scratch (si scratch pe ale ei)
+    int stepsSinceReorder;
+    int reorderCount;
+    double reorderTime;     // cat a durat ultima reordonare
+    double baseStepTime;    // timpul pe pas al primului segment dupa ultima reordonare
+    double lostTime;        // cat au durat pasii de dupa el mai mult decat baseStepTime
+    Population *scratch;
+    int *order;
+    uint64_t *key;
+    uint64_t *keyBuffer;
+    int *value;
+    int *valueBuffer;
+    int *threadCounts;      // threadCount x SPARSE_RADIX_BUCKETS histograme pentru sortare
+}PersonOrder;
+
+// starea lui fastForward: simularea pana unde a ajuns engine-ul si ce s-a gasit pe drum
+typedef struct {
+    SimulationEngine engine;
+    CellIndex *grid;
+    Population *population;
+    SimulationData segment;     // startStep e pasul la care a ajuns simularea
+    int simulationTime;
+    long long movementPeriod;   // 0 daca e mai mare decat simularea
+    int cycleStart;             // pasul de la care starea se repeta, -1 daca nu a fost gasit
+    long long cycleLength;
+    long long skippedCycles;
+    int extinctStep;            // pasul de dupa care nu mai e nicio persoana infectata sau imuna, -1 daca nu exista
+}FastForward;
+
+// scenariile unui ansamblu, pe biti: bitul s al fiecarui cuvant e starea persoanei in scenariul s
+typedef struct {
+    int scenarioCount;
+    uint64_t scenarioMask;      // bitii scenariilor folosite
+    int planes;                 // numarul de biti ai duratei
+    uint64_t *infected;         // un cuvant pe persoana
+    uint64_t *immune;           // un cuvant pe persoana, susceptibil = nici infectat, nici imun
+    uint64_t *duration;         // planes cuvinte pe persoana, cuvantul b are bitul b al duratei in fiecare scenariu
+    int *infectionCounter;      // ENSEMBLE_MAX_SCENARIOS pe persoana
+}Ensemble;
+
+// o populatie simulata cate cativa pasi o data (stepSession), cu grid-ul ei pastrat intre apeluri
+typedef struct {
+    SimulationData simulation;  // startStep e pasul la care a ajuns populatia
+    Population *population;
+    CellIndex *grid;
+    int threadCount;            // thread-urile pentru care e alocat grid-ul
+}Session;
+
+// un client al serverului si comanda pe care o citeste
+typedef struct {
+    int fd;                     // -1 daca locul e liber
+    int length;
+    char line[SERVER_LINE_LENGTH];
+}ServerClient;
+
+// serverul: populatiile tinute in memorie (indexul e id-ul lor) si clientii conectati
+typedef struct {
+    int listenFd;
+    int threadCount;            // thread-urile cu care sunt incarcate populatiile
+    int running;
+    Session *sessions[SERVER_MAX_POPULATIONS];
+    ServerClient clients[SERVER_MAX_CLIENTS];
+}Server;
+
+// checkpoint-urile unei simulari: la fiecare checkpoint starea e copiata in copy si scrisa de un thread separat,
+// cat timp simularea merge mai departe pe populatia ei
+typedef struct {
+    char *path;
+    char *temporaryPath;
+    int every;
+    Population *copy;
+    SimulationData simulation;  // simularea copiei, cu pasul checkpoint-ului in simulationTime
+    pthread_t writer;
+    int writing;
+}Checkpointer;
+
+InputFile openInputFile(const char *path);
+int tryOpenInputFile(const char *path, InputFile *input, char *error);
+InputFile mapInputFile(int fd);
+int tryMapInputFile(int fd, InputFile *input, char *error);
+void closeInputFile(InputFile *input);
+void simulationScan(InputFile *input, SimulationData *simulation);
+int trySimulationScan(InputFile *input, SimulationData *simulation, char *error);
+void setDurations(Population *population, SimulationData *simulation, int infectedDuration, int immuneDuration);
+void personScan(InputFile *input, Population *population, SimulationData *simulation, int threadCount);
+int tryPersonScan(InputFile *input, Population *population, SimulationData *simulation, int threadCount, char *error);
+int parseLine(const char *cursor, const char *end, int *values, int maxValues, const char **nextLine);
+int checkRow(const int *values, SimulationData *simulation, char *error);
+void initPerson(Population *population, int index, const int *values, SimulationData *simulation);
+void addInputError(InputErrors *errors, int line, const char *error);
+void personPrintToFile(int fd, Population *population, SimulationData *simulation, int format);
+int tryPersonPrintToFile(int fd, Population *population, SimulationData *simulation, int format, char *error);
+char *formatPerson(char *cursor, Population *population, int index, int format);
+char *formatInt(char *cursor, int value);
+void personPrintToConsole(Population *population, SimulationData *simulation);
+void updateLocation(Population *population, int index, SimulationData *simulation);
+// void computeNextStatus(Person *person, int index, SimulationData *simulation); // first version
+void computeNextStatus(CellIndex *grid, Population *population, SimulationData *simulation, StepStatistics *step);
+void updateStatus(Population *population, int index, SimulationData *simulation);
+void computeCellNextStatus(const int *cellPersons, int cellSize, Population *population, StepStatistics *step);
+void simulateSerial(CellIndex *grid, Population *population, SimulationData *simulation, StatisticsStream *statistics);
+void computeNextStatusParallel(CellIndex *grid, Population *population, SimulationData *simulation, StepStatistics *step);
+void simulateParallel(CellIndex *grid, Population *population, SimulationData *simulation, StatisticsStream *statistics);
+void simulateParallelFused(CellIndex *grid, Population *population, SimulationData *simulation, StatisticsStream *statistics);
+void simulateParallelActive(CellIndex *grid, Population *population, SimulationData *simulation, StatisticsStream *statistics);
+ActiveSet *allocActiveSet(int numberOfPersons, int threadCount);
+ActiveSet *tryAllocActiveSet(int numberOfPersons, int threadCount);
+void freeActiveSet(ActiveSet *active);
+void insertInfectedCell(ActiveSet *active, uint64_t key);
+int isInfectedCell(ActiveSet *active, uint64_t key);
+
+void updateStatusScalar(Population *population, int first, int last, SimulationData *simulation);
+void updateLocationScalar(Population *population, int first, int last, SimulationData *simulation);
+#ifdef HAVE_X86_KERNELS
+void updateStatusAVX2(Population *population, int first, int last, SimulationData *simulation);
+void updateLocationAVX2(Population *population, int first, int last, SimulationData *simulation);
+void updateStatusAVX512(Population *population, int first, int last, SimulationData *simulation);
+void updateLocationAVX512(Population *population, int first, int last, SimulationData *simulation);
+#endif
+int kernelsSupported(int kernelType);
+UpdateKernels getKernels(int kernelType);
+int checkKernels(Population *population, SimulationData *simulation);
+int verifyEngines(SimulationEngine engine, CellIndex *serialGrid, CellIndex *parallelGrid, Population *population, SimulationData *simulation,
+                  int every);
+void threadRange(int count, int blockSize, int *first, int *last);
+void blockRange(int count, int blockSize, int threadID, int threadCount, int *first, int *last);
+
+Population *allocPopulation(int numberOfPersons);
+Population *tryAllocPopulation(int numberOfPersons);
+void *alignedArray(size_t count, size_t elementSize);
+void *tryAlignedArray(size_t count, size_t elementSize);
+void copyPopulation(Population *destination, Population *source, int numberOfPersons);
+int comparePopulation(Population *first, Population *second, int numberOfPersons);
+void freePopulation(Population *population);
+void populationArrays(Population *population, void **arrays[POPULATION_ARRAY_COUNT]);
+int checkPopulation(Population *population, SimulationData *simulation);
+
+int isSnapshot(InputFile *input);
+size_t snapshotLayout(int numberOfPersons, size_t offsets[POPULATION_ARRAY_COUNT]);
+Population *loadSnapshot(InputFile *input, SimulationData *simulation);
+Population *tryLoadSnapshot(InputFile *input, SimulationData *simulation, char *error);
+void saveSnapshot(const char *path, Population *population, SimulationData *simulation, int step);
+void writeSnapshot(int fd, Population *population, SimulationData *simulation, int step);
+int tryWriteSnapshot(int fd, Population *population, SimulationData *simulation, int step, char *error);
+int memorySnapshot(Population *population, SimulationData *simulation);
+void initSnapshotHeader(SnapshotHeader *header, SimulationData *simulation, int step);
+void writeAll(int fd, const void *buffer, size_t size);
+int tryWriteAll(int fd, const void *buffer, size_t size);
+
+void initGrid(CellIndex *grid, Population *population, SimulationData *simulation);
+void updateGrid(CellIndex *grid, Population *population, SimulationData *simulation);
+void updateGridParallel(CellIndex *grid, Population *population, SimulationData *simulation);
+void countPersonCells(CellIndex *grid, Population *population, SimulationData *simulation, int first, int last, int *count);
+void buildCellOffsets(CellIndex *grid);
+void scatterPersons(CellIndex *grid, int first, int last, int *count);
+void sortPersonCells(CellIndex *grid, Population *population, SimulationData *simulation);
+void sortPersonCellsTeam(CellIndex *grid, Population *population, SimulationData *simulation, int thread, int threadCount,
+                         BarrierFunction wait, void *barrier);
+void ompBarrier(void *unused);
+void noBarrier(void *unused);
+void radixSortPairs(uint64_t *key, int *value, uint64_t *keyBuffer, int *valueBuffer, int passes, int first, int last, int *threadCounts,
+                    int thread, int threadCount, BarrierFunction wait, void *barrier);
+
+void simulatePthreads(CellIndex *grid, Population *population, SimulationData *simulation, StatisticsStream *statistics);
+PthreadsTeam *startPthreadsTeam(CellIndex *grid);
+PthreadsTeam *tryStartPthreadsTeam(CellIndex *grid, char *error);
+void stopPthreadsTeam(PthreadsTeam *team);
+void *pthreadsWorker(void *argument);
+void pthreadsSteps(PthreadsWorker *worker);
+void pthreadsBuildGrid(PthreadsWorker *worker);
+void pthreadsInfection(PthreadsWorker *worker);
+int firstCellFrom(CellIndex *grid, int position);
+int tryInitPhaseBarrier(PhaseBarrier *barrier, int type, int threadCount);
+void phaseBarrierWait(PhaseBarrier *barrier, int *localSense);
+void destroyPhaseBarrier(PhaseBarrier *barrier);
+void pthreadsBarrier(void *worker);
+
+void printGrid(CellIndex *grid, Population *population, SimulationData *simulation);
+void printList(const int *cellPersons, int cellSize, Population *population);
+
+CellIndex *allocGrid(SimulationData *simulation, int threadCount, int gridType);
+CellIndex *tryAllocGrid(SimulationData *simulation, int threadCount, int gridType, char *error);
+void freeGrid(CellIndex *grid);
+
+char *buildOutputPath(const char *inputPath, char *suffix);
+void writeOutput(const char *outputPath, Population *population, SimulationData *simulation, int format);
+Population *loadPopulation(const char *path, SimulationData *simulation, int threadCount);
+Population *tryLoadPopulation(const char *path, SimulationData *simulation, int threadCount, char *error);
+void runEngine(SimulationEngine engine, CellIndex *grid, Population *population, SimulationData *simulation, Checkpointer *checkpointer,
+               PersonOrder *order, StatisticsStream *statistics);
+int trajectoryPeriod(int position, int direction, int amplitude, int length, int *transient);
+void locationAfter(Population *population, int index, SimulationData *simulation, long long steps);
+long long movementPeriod(Population *population, SimulationData *simulation, long long limit, int *transient);
+uint64_t stateHash(Population *population, int n, int threadCount);
+int sameState(Population *first, Population *second, int n);
+int advance(FastForward *forward, long long steps);
+void fastForward(SimulationEngine engine, CellIndex *grid, Population *population, SimulationData *simulation, FastForward *forward);
+Ensemble *allocEnsemble(Population *population, SimulationData *simulation, int scenarioCount, double infectedFraction, uint64_t seed);
+void freeEnsemble(Ensemble *ensemble);
+uint64_t ensembleRandom(uint64_t seed, int scenario, int index);
+void simulateEnsemble(CellIndex *grid, Population *population, Ensemble *ensemble, SimulationData *simulation);
+void ensemblePerson(Ensemble *ensemble, int index, uint64_t cellInfected, SimulationData *simulation);
+void extractScenario(Ensemble *ensemble, int scenario, Population *population, SimulationData *simulation);
+void ensembleCounts(Ensemble *ensemble, int n, int *infected, int *immune, long long *infections);
+Session *openSession(const char *path, int threadCount, int infectedDuration, int immuneDuration, char *error);
+int stepSession(Session *session, SimulationEngine engine, int steps, int threadCount, StatisticsStream *statistics, char *error);
+int prepareEngine(CellIndex *grid, SimulationEngine engine, SimulationData *simulation, char *error);
+void closeSession(Session *session);
+int runServer(const char *socketPath, int threadCount);
+int readClient(Server *server, ServerClient *client);
+int serverCommand(Server *server, int fd, char *line);
+int serverLoad(Server *server, int fd, char **arguments, int count);
+int serverRun(Server *server, int fd, char **arguments, int count);
+int serverResult(Server *server, int fd, char **arguments, int count);
+int serverNumber(const char *text, int *value);
+Session *serverSession(Server *server, int fd, const char *id);
+int serverReply(int fd, const char *format, ...);
+int sendAll(int fd, const void *buffer, size_t size);
+int sendMemoryFile(int fd, const char *kind, int memoryFd);
+PersonOrder *allocPersonOrder(int numberOfPersons, int every, int curve);
+void freePersonOrder(PersonOrder *order);
+int reorderDue(PersonOrder *order);
+int reorderSegment(PersonOrder *order);
+void recordSegment(PersonOrder *order, int steps, double time);
+uint64_t curveKey(int curve, int levels, uint32_t x, uint32_t y);
+uint64_t spreadBits(uint32_t value);
+void reorderPopulation(PersonOrder *order, Population *population, SimulationData *simulation);
+void restorePopulationOrder(PersonOrder *order, Population *population);
+void movePersons(PersonOrder *order, Population *population, const int *index, int scatter);
+void swapPopulationArrays(Population *first, Population *second);
+void sortPersonKeys(PersonOrder *order, int n, int keyBits);
+Checkpointer *createCheckpointer(const char *inputPath, char *suffix, int every, SimulationData *simulation);
+void startCheckpoint(Checkpointer *checkpointer, Population *population, SimulationData *simulation);
+void *checkpointWriter(void *argument);
+void finishCheckpoint(Checkpointer *checkpointer);
+void freeCheckpointer(Checkpointer *checkpointer);
+void resumeFromCheckpoint(const char *inputPath, char *suffix, Population **population, SimulationData *simulation, const char *name);
+StatisticsStream *openStatistics(const char *path, int format, SimulationData *simulation);
+StatisticsStream *streamStatistics(int fd, int format, SimulationData *simulation);
+StatisticsStream *tryStreamStatistics(int fd, int format, SimulationData *simulation, char *error);
+void writeStatistics(StatisticsStream *statistics, const void *buffer, size_t size);
+void recordStep(StatisticsStream *statistics, StepStatistics *step);
+void flushStatistics(StatisticsStream *statistics);
+void closeStatistics(StatisticsStream *statistics);
+void releaseStatistics(StatisticsStream *statistics);
+int tryReleaseStatistics(StatisticsStream *statistics, char *error);
+double elapsedSeconds(struct timespec *start, struct timespec *finish);
+
+#ifdef PROFILE_PHASES
+void profileBegin(const char *name, int threadCount);
+void profileStart(int phase);
+void profileStop(int phase, long long items);
+void profileAllocation();
+void profileEnd(const char *tracePath);
+#endif
+
+// kernel-urile folosite de simulateParallel, alese in main in functie de procesor
+extern UpdateKernels kernels;
+
+// bariera dintre fazele lui simulatePthreads (BARRIER_SPIN daca nu e aleasa alta in main)
+extern int barrierType;
+
+// dimensiunea unui element din fiecare array al populatiei, in ordinea din populationArrays
+extern const size_t populationElementSize[POPULATION_ARRAY_COUNT];
+
+#endif
@@ -0,0 +1,238 @@
+#include "epidemics.h"
+
+/*-----------------------------------------------------------------
+ * Function:  Trajectory Period
+ * Purpose:   Closed form of the movement of one person on an axis of length cells: it goes by amplitude cells per step until
+            it is clamped to a wall, after which it goes back and forth between the walls; both legs take length - 1 / amplitude + 1
+            steps (the last one is the clamp), so the (position, direction) pair repeats every 2 * (length - 1 / amplitude + 1) steps
+ * In args:   position, direction, amplitude, length
+ * Out args:  transient (steps until the first clamp, after which the trajectory is periodic)
+ * Return:    the period
+ */
+int trajectoryPeriod(int position, int direction, int amplitude, int length, int *transient) {
+    if(amplitude == 0) {
+        *transient = 0;
+        return 1;
+    }
+
+    int forward = direction == NORTH || direction == EAST;
+    *transient = (forward ? length - 1 - position : position) / amplitude + 1;
+    return 2 * ((length - 1) / amplitude + 1);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Location After
+ * Purpose:   Move the person at index by steps steps in closed form, with the same result as steps calls of updateLocation
+ * In args:   population, index, simulation, steps
+ */
+void locationAfter(Population *population, int index, SimulationData *simulation, long long steps) {
+    int direction = population->movementDirection[index];
+    int amplitude = population->movementAmplitude[index];
+    int alongX = direction == NORTH || direction == SOUTH;
+    int length = alongX ? simulation->maxXCoord : simulation->maxYCoord;
+    int position = alongX ? population->x[index] : population->y[index];
+    int forward = direction == NORTH || direction == EAST;
+    if(amplitude == 0 || steps == 0) return;
+
+    int transient;
+    int period = trajectoryPeriod(position, direction, amplitude, length, &transient);
+    if(steps < transient) {
+        position += (forward ? 1 : -1) * (int)steps * amplitude;
+    } else {
+        // la pasul transient persoana e la perete si merge inapoi; o jumatate de perioada pana la celalalt perete
+        long long phase = (steps - transient) % period;
+        int half = period / 2;
+        int fromTop = forward;
+        if(phase >= half) {
+            phase -= half;
+            fromTop = !fromTop;
+        }
+        position = fromTop ? length - 1 - (int)phase * amplitude : (int)phase * amplitude;
+        // fromTop: persoana coboara (SOUTH / WEST)
+        direction = (alongX ? NORTH : EAST) | fromTop;
+    }
+
+    if(alongX) {
+        population->x[index] = position;
+    } else {
+        population->y[index] = position;
+    }
+    population->movementDirection[index] = direction;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Movement Period
+ * Purpose:   The period of the movement of all persons (the least common multiple of their trajectory periods) and the step
+            after which all of them are periodic
+ * In args:   population, simulation, limit
+ * Out args:  transient
+ * Return:    the period, or 0 if it is larger than limit (no state can repeat in limit steps)
+ */
+long long movementPeriod(Population *population, SimulationData *simulation, long long limit, int *transient) {
+    long long period = 1;
+    *transient = 0;
+    for(int i=0;i<simulation->numberOfPersons;i++) {
+        int direction = population->movementDirection[i];
+        int alongX = direction == NORTH || direction == SOUTH;
+        int personTransient;
+        int personPeriod = trajectoryPeriod(alongX ? population->x[i] : population->y[i], direction, population->movementAmplitude[i],
+                                            alongX ? simulation->maxXCoord : simulation->maxYCoord, &personTransient);
+        if(personTransient > *transient) *transient = personTransient;
+        if(period % personPeriod != 0) {
+            long long a = period, b = personPeriod;
+            while(b) {
+                long long r = a % b;
+                a = b;
+                b = r;
+            }
+            period = period / a * personPeriod;
+            if(period > limit) return 0;
+        }
+    }
+
+    return period;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  State Hash
+ * Purpose:   Hash of the state of all persons that decides the next steps (position, direction, status, duration); infectionCounter
+            is left out, it only accumulates; the hashes of the persons are added, so the threads can add them in any order
+ * In args:   population, n, threadCount (the threads of the engine)
+ */
+uint64_t stateHash(Population *population, int n, int threadCount) {
+    uint64_t hash = 0;
+    #pragma omp parallel for schedule(static) reduction(+:hash) num_threads(threadCount)
+    for(int i=0;i<n;i++) {
+        uint64_t value = (uint64_t)i;
+        value = value * 0x9E3779B97F4A7C15ULL + population->x[i];
+        value = value * 0x9E3779B97F4A7C15ULL + population->y[i];
+        value = value * 0x9E3779B97F4A7C15ULL + ((uint64_t)population->movementDirection[i] << 16 | population->status[i] << 8 |
+                                                 population->statusDuration[i]);
+        value ^= value >> 31;
+        value *= 0xBF58476D1CE4E5B9ULL;
+        value ^= value >> 29;
+        hash += value;
+    }
+    return hash;
+}
+
+int sameState(Population *first, Population *second, int n) {
+    for(int i=0;i<n;i++) {
+        if(first->x[i] != second->x[i] || first->y[i] != second->y[i] || first->movementDirection[i] != second->movementDirection[i] ||
+           first->status[i] != second->status[i] || first->statusDuration[i] != second->statusDuration[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Advance
+ * Purpose:   Run the engine of fastForward steps more, FAST_FORWARD_CHECK_STEPS at a time; when no person is infected or immune any more
+            only the movement is left, so all the persons are moved to simulationTime in closed form; the checks run on the
+            threads of the grid of the engine, so the serial engine stays on one thread
+ * In args:   forward, steps
+ * Return:    1 if the simulation got to simulationTime
+ */
+int advance(FastForward *forward, long long steps) {
+    SimulationData *segment = &forward->segment;
+    int threadCount = forward->grid->threadCount;
+    long long stop = segment->startStep + steps;
+    if(stop > forward->simulationTime) stop = forward->simulationTime;
+
+    while(segment->startStep < stop) {
+        segment->simulationTime = stop - segment->startStep > FAST_FORWARD_CHECK_STEPS ? segment->startStep + FAST_FORWARD_CHECK_STEPS : (int)stop;
+        forward->engine(forward->grid, forward->population, segment, NULL);
+        segment->startStep = segment->simulationTime;
+
+        int active = 0;
+        #pragma omp parallel for schedule(static) reduction(+:active) num_threads(threadCount)
+        for(int i=0;i<segment->numberOfPersons;i++) {
+            active += forward->population->status[i] != SUSCEPTIBLE;
+        }
+        if(active == 0) {
+            long long remaining = forward->simulationTime - segment->startStep;
+            #pragma omp parallel for schedule(static) num_threads(threadCount)
+            for(int i=0;i<segment->numberOfPersons;i++) {
+                locationAfter(forward->population, i, segment, remaining);
+            }
+            forward->extinctStep = segment->startStep;
+            segment->startStep = forward->simulationTime;
+        }
+    }
+
+    return segment->startStep >= forward->simulationTime;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Fast Forward
+ * Purpose:   Run engine from simulation->startStep to simulation->simulationTime, skipping the repetitions of the whole state: after the
+            transient of the movement, the state can only repeat after a multiple of the movement period, so it is compared every period
+            steps with Brent's cycle detection (a hash, then the full state); once the state of step t repeats at step t + cycle,
+            the whole cycles left are skipped, every person getting the infections of one cycle times their number, and only
+            the steps after them are run; the statistics of the skipped steps are not computed
+ * In args:   engine, grid, population, simulation
+ * Out args:  forward (what was found: the movement period, the cycle, the step at which the epidemic ended)
+ */
+void fastForward(SimulationEngine engine, CellIndex *grid, Population *population, SimulationData *simulation, FastForward *forward) {
+    forward->engine = engine;
+    forward->grid = grid;
+    forward->population = population;
+    forward->segment = *simulation;
+    forward->simulationTime = simulation->simulationTime;
+    forward->cycleStart = -1;
+    forward->cycleLength = 0;
+    forward->skippedCycles = 0;
+    forward->extinctStep = -1;
+
+    int n = simulation->numberOfPersons;
+    int threadCount = grid->threadCount;
+    int transient;
+    forward->movementPeriod = movementPeriod(population, simulation, simulation->simulationTime - simulation->startStep, &transient);
+    if(advance(forward, transient)) return;
+    if(forward->movementPeriod == 0) {
+        advance(forward, forward->simulationTime);
+        return;
+    }
+
+    // Brent: saved e starea de la o putere a lui 2 de perioade, comparata cu fiecare stare de dupa ea
+    Population *saved = allocPopulation(n);
+    copyPopulation(saved, population, n);
+    uint64_t savedHash = stateHash(population, n, threadCount);
+    int savedStep = forward->segment.startStep;
+    long long power = 1, length = 1;
+    if(advance(forward, forward->movementPeriod)) {
+        freePopulation(saved);
+        return;
+    }
+
+    while(stateHash(population, n, threadCount) != savedHash || !sameState(population, saved, n)) {
+        if(power == length) {
+            copyPopulation(saved, population, n);
+            savedHash = stateHash(population, n, threadCount);
+            savedStep = forward->segment.startStep;
+            power *= 2;
+            length = 0;
+        }
+        if(advance(forward, forward->movementPeriod)) {
+            freePopulation(saved);
+            return;
+        }
+        length++;
+    }
+
+    // infectiile unui ciclu se repeta la fiecare ciclu
+    long long cycle = forward->segment.startStep - savedStep;
+    long long cycles = (forward->simulationTime - forward->segment.startStep) / cycle;
+    #pragma omp parallel for schedule(static) num_threads(threadCount)
+    for(int i=0;i<n;i++) {
+        population->infectionCounter[i] += (int)(cycles * (population->infectionCounter[i] - saved->infectionCounter[i]));
+    }
+    forward->cycleStart = savedStep;
+    forward->cycleLength = cycle;
+    forward->skippedCycles = cycles;
+    forward->segment.startStep += (int)(cycles * cycle);
+    freePopulation(saved);
+
+    advance(forward, forward->simulationTime);
+}
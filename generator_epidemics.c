@@ -4,134 +4,590 @@
  * Accepts as input:
  * Size  of grid maxX*maxY points
  * Number of persons N - give a reasonable value for N relative to the number of grid points
- * infectionPercentage - the percentage of persons initially infected 
+ * infectionPercentage - the percentage of persons initially infected
+ *
+ * Without arguments the values are read interactively; otherwise:
+ * ./generator maxX maxY N infectionPercentage [--seed=S] [--threads=T] [--output=path] [--mode=...]
+ * The random numbers are counter based: the k-th number of person i only depends on (seed, i, k), so the persons
+ * are generated and written by all threads in parallel and the same seed gives the same file for any number of threads.
+ * An output path ending in .bin is written directly as a binary snapshot.
+ * Besides uniform placement, the modes make the skewed workloads that load the simulator unevenly:
+ * clusters - persons around K Gaussian hotspots (sigma = spread cells)
+ * powerlaw - cell densities follow a power law: the k-th most crowded cell gets persons proportional to 1 / k^alpha
+ * corridor - commuters on K horizontal / vertical corridors (spread cells wide), moving back and forth along them
  */
 
-#include <stdio.h>
-#include <stdlib.h>
-#include <time.h>
+#include <math.h>
+
+#include "epidemics.h"
+
+#define GENERATOR_ARGUMENT_COUNT 5
+#define SEED_OPTION "--seed="
+#define THREADS_OPTION "--threads="
+#define OUTPUT_OPTION "--output="
+#define MODE_OPTION "--mode="
+#define GROUPS_OPTION "--groups="
+#define SPREAD_OPTION "--spread="
+#define ALPHA_OPTION "--alpha="
+#define DEFAULT_SEED 1
+#define DEFAULT_GROUPS 8
+#define DEFAULT_ALPHA 1.0
+#define GROUP_SEED 0xC1C1C1C1C1C1C1C1ULL // the hotspots and corridors get their own random numbers, indexed by group
+#define MAX_FILENAME_LENGTH 4096
+
+// the random numbers drawn for every person, in this order
+typedef enum
+{
+    RANDOM_X,
+    RANDOM_Y,
+    RANDOM_DIRECTION,
+    RANDOM_AMPLITUDE,
+    RANDOM_GROUP,
+    RANDOM_OFFSET_X, // the Gaussian offsets take two numbers each
+    RANDOM_ANGLE_X,
+    RANDOM_OFFSET_Y,
+    RANDOM_ANGLE_Y,
+    RANDOM_COUNT
+} RandomFields;
+
+typedef enum
+{
+    MODE_UNIFORM,
+    MODE_CLUSTERS,
+    MODE_POWERLAW,
+    MODE_CORRIDOR
+} GeneratorModes;
 
 typedef struct
 {
-    int personID;
-    int x;
-    int y;
-    int status;    // 0=infected, 1=susceptible
-    int direction; // 0: N, 1: S, 2: E, 3: W
-    int amplitude;
-} Person;
+    int maxX;
+    int maxY;
+    int N;
+    int infectionPercentage;
+    uint64_t seed;
+    int threadCount;
+    char filename[MAX_FILENAME_LENGTH];
+    int mode;
+    int groups;   // hotspots (clusters) or corridors (corridor)
+    double spread; // sigma of a hotspot or width of a corridor, in cells
+    double alpha;  // exponent of the power law
+} GeneratorOptions;
+
+uint64_t mix64(uint64_t value);
+uint64_t randomNumber(uint64_t seed, uint64_t index, int counter);
+int randomBelow(uint64_t seed, uint64_t index, int counter, int bound);
+double randomUnit(uint64_t seed, uint64_t index, int counter);
+double randomGaussian(uint64_t seed, uint64_t index, int counter);
+int clampCoordinate(double value, int max);
+void placeCluster(GeneratorOptions *options, int index, int *values);
+void placePowerLaw(GeneratorOptions *options, int index, int *values);
+void placeCorridor(GeneratorOptions *options, int index, int *values);
+uint64_t permuteIndex(uint64_t index, uint64_t count, uint64_t seed);
+void generatePerson(GeneratorOptions *options, int infectedCount, int index, int *values);
+void generateChunk(GeneratorOptions *options, int infectedCount, Population *chunk, int first, int last);
+void generatePersons(GeneratorOptions *options);
+void writeTextBlock(int fd, GeneratorOptions *options, int infectedCount, Population *chunk, char *buffer, int first, int last, long long offset);
+long long measureTextBlock(GeneratorOptions *options, int infectedCount, Population *chunk, char *buffer, int first, int last);
+void defaultFilename(GeneratorOptions *options);
+void readInteractive(GeneratorOptions *options);
+void parseGeneratorOptions(int argc, const char *argv[], GeneratorOptions *options);
+void generatorUsage();
+
+/**
+ * SplitMix64 finalizer: a bijective mix of the 64 bits of value
+ */
+uint64_t mix64(uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+/**
+ * The counter-th random number of person index: a hash of (seed, index, counter), with no state shared between threads
+ */
+uint64_t randomNumber(uint64_t seed, uint64_t index, int counter)
+{
+    return mix64(mix64(seed + 0x9E3779B97F4A7C15ULL) ^ (index * RANDOM_COUNT + counter));
+}
+
+/**
+ * A random number in [0, bound), from the high 32 bits of randomNumber (multiply-shift instead of %)
+ */
+int randomBelow(uint64_t seed, uint64_t index, int counter, int bound)
+{
+    return (int)(((randomNumber(seed, index, counter) >> 32) * (uint64_t)bound) >> 32);
+}
+
+/**
+ * A random number in [0, 1), with 53 random bits
+ */
+double randomUnit(uint64_t seed, uint64_t index, int counter)
+{
+    return (randomNumber(seed, index, counter) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * A normally distributed random number (mean 0, sigma 1), Box-Muller on the counter-th and the next random number
+ */
+double randomGaussian(uint64_t seed, uint64_t index, int counter)
+{
+    double radius = sqrt(-2.0 * log(1.0 - randomUnit(seed, index, counter)));
+    return radius * cos(2.0 * M_PI * randomUnit(seed, index, counter + 1));
+}
 
-void generatePersons(const char *filename, int N, int maxX, int maxY, int infectionPercentage)
+int clampCoordinate(double value, int max)
 {
-    FILE *file = fopen(filename, "w");
-    if (!file)
+    if (value < 0)
+        return 0;
+    if (value > max - 1)
+        return max - 1;
+    return (int)value;
+}
+
+/**
+ * A random permutation of [0, count), evaluated for one index: a 4 round Feistel network on the smallest
+ * power of 4 >= count, repeated while the result is outside [0, count) (cycle walking)
+ * The persons with permuteIndex < infectedCount are infected, so there are exactly infectedCount of them,
+ * randomly placed, without shuffling an array of statuses
+ */
+uint64_t permuteIndex(uint64_t index, uint64_t count, uint64_t seed)
+{
+    int halfBits = 1;
+    while ((1ULL << (2 * halfBits)) < count)
+        halfBits++;
+    uint64_t mask = (1ULL << halfBits) - 1;
+
+    do
     {
-        printf("Error opening file\n");
-        exit(1);
+        uint64_t left = index >> halfBits;
+        uint64_t right = index & mask;
+        for (int round = 0; round < 4; round++)
+        {
+            uint64_t next = left ^ (mix64(right ^ mix64(seed + round)) & mask);
+            left = right;
+            right = next;
+        }
+        index = (left << halfBits) | right;
+    } while (index >= count);
+
+    return index;
+}
+
+/**
+ * Clusters mode: the person is placed around the center of a random hotspot, Gaussian on both axes,
+ * and moves like in the uniform mode
+ */
+void placeCluster(GeneratorOptions *options, int index, int *values)
+{
+    int group = randomBelow(options->seed, index, RANDOM_GROUP, options->groups);
+    int centerX = randomBelow(options->seed ^ GROUP_SEED, group, RANDOM_X, options->maxX);
+    int centerY = randomBelow(options->seed ^ GROUP_SEED, group, RANDOM_Y, options->maxY);
+
+    values[1] = clampCoordinate(centerX + 0.5 + options->spread * randomGaussian(options->seed, index, RANDOM_OFFSET_X), options->maxX);
+    values[2] = clampCoordinate(centerY + 0.5 + options->spread * randomGaussian(options->seed, index, RANDOM_OFFSET_Y), options->maxY);
+}
+
+/**
+ * Power law mode: the person goes to the cell of rank k in [1, maxX * maxY], drawn with probability proportional to 1 / k^alpha
+ * (inverse of the distribution function of the continuous power law); the ranks are spread over the grid by a random permutation
+ */
+void placePowerLaw(GeneratorOptions *options, int index, int *values)
+{
+    uint64_t cellCount = (uint64_t)options->maxX * options->maxY;
+    double u = randomUnit(options->seed, index, RANDOM_GROUP);
+    double rank;
+    if (fabs(options->alpha - 1.0) < 1e-9)
+        rank = pow((double)cellCount, u);
+    else
+        rank = pow((pow((double)cellCount, 1.0 - options->alpha) - 1.0) * u + 1.0, 1.0 / (1.0 - options->alpha));
+
+    uint64_t k = (uint64_t)rank;
+    if (k < 1)
+        k = 1;
+    if (k > cellCount)
+        k = cellCount;
+    uint64_t cell = permuteIndex(k - 1, cellCount, options->seed ^ GROUP_SEED);
+    values[1] = (int)(cell / options->maxY);
+    values[2] = (int)(cell % options->maxY);
+}
+
+/**
+ * Corridor mode: even corridors are rows (constant x, the commuters move E / W), odd ones are columns (constant y, they move N / S);
+ * a commuter is anywhere along its corridor, at most spread / 2 cells off its middle, and crosses the grid with a long amplitude
+ */
+void placeCorridor(GeneratorOptions *options, int index, int *values)
+{
+    int group = randomBelow(options->seed, index, RANDOM_GROUP, options->groups);
+    double offset = (randomUnit(options->seed, index, RANDOM_OFFSET_X) - 0.5) * options->spread;
+    int horizontal = group % 2 == 0;
+    int across = horizontal ? options->maxX : options->maxY;
+    int along = horizontal ? options->maxY : options->maxX;
+    int middle = randomBelow(options->seed ^ GROUP_SEED, group, RANDOM_X, across);
+
+    int position = randomBelow(options->seed, index, RANDOM_Y, along);
+    int lane = clampCoordinate(middle + 0.5 + offset, across);
+    values[1] = horizontal ? lane : position;
+    values[2] = horizontal ? position : lane;
+
+    values[4] = (horizontal ? 2 : 0) + randomBelow(options->seed, index, RANDOM_DIRECTION, 2); // E / W on rows, N / S on columns
+    values[5] = along / 4 + 1 + randomBelow(options->seed, index, RANDOM_AMPLITUDE, along / 4 + 1);
+}
+
+/**
+ * The PERSON_FIELD_COUNT values of the input row of person index
+ */
+void generatePerson(GeneratorOptions *options, int infectedCount, int index, int *values)
+{
+    values[0] = index + 1;                                               // personID
+    values[1] = randomBelow(options->seed, index, RANDOM_X, options->maxX - 1); // x coordinate
+    values[2] = randomBelow(options->seed, index, RANDOM_Y, options->maxY - 1); // y coordinate
+    values[3] = permuteIndex(index, options->N, options->seed) < (uint64_t)infectedCount ? 0 : 1; // 0=infected, 1=susceptible
+
+    // movement direction and amplitude
+    values[4] = randomBelow(options->seed, index, RANDOM_DIRECTION, 4); // direction (0=N 1=S 2=E 3=W)
+    if ((values[4] == 0) || (values[4] == 1))                           // N,S
+        values[5] = 1 + randomBelow(options->seed, index, RANDOM_AMPLITUDE, options->maxY / 2); // movement amplitude must be at least 1
+    else                                                                // E, W
+        values[5] = 1 + randomBelow(options->seed, index, RANDOM_AMPLITUDE, options->maxX / 2);
+
+    if (options->mode == MODE_CLUSTERS)
+        placeCluster(options, index, values);
+    else if (options->mode == MODE_POWERLAW)
+        placePowerLaw(options, index, values);
+    else if (options->mode == MODE_CORRIDOR)
+        placeCorridor(options, index, values);
+}
+
+/**
+ * Generate the persons [first, last) in chunk (at positions 0 .. last - first), initialized like a loaded input file
+ */
+void generateChunk(GeneratorOptions *options, int infectedCount, Population *chunk, int first, int last)
+{
+    SimulationData simulation = {options->maxX, options->maxY, options->N, 0, 0, INFECTED_DURATION, IMMUNE_DURATION};
+    int values[PERSON_FIELD_COUNT];
+    for (int i = first; i < last; i++)
+    {
+        generatePerson(options, infectedCount, i, values);
+        initPerson(chunk, i - first, values, &simulation);
+    }
+}
+
+/**
+ * Length of the text rows of the persons [first, last), formatted in chunks of OUTPUT_CHUNK_PERSONS
+ */
+long long measureTextBlock(GeneratorOptions *options, int infectedCount, Population *chunk, char *buffer, int first, int last)
+{
+    long long length = 0;
+    for (int chunkStart = first; chunkStart < last; chunkStart += OUTPUT_CHUNK_PERSONS)
+    {
+        int chunkEnd = chunkStart + OUTPUT_CHUNK_PERSONS < last ? chunkStart + OUTPUT_CHUNK_PERSONS : last;
+        generateChunk(options, infectedCount, chunk, chunkStart, chunkEnd);
+        char *cursor = buffer;
+        for (int i = 0; i < chunkEnd - chunkStart; i++)
+            cursor = formatPerson(cursor, chunk, i, INPUT_PRINT_FORMAT);
+        length += cursor - buffer;
     }
+    return length;
+}
+
+/**
+ * Write the text rows of the persons [first, last) at offset; the persons are generated again, which is cheaper
+ * than keeping the rows of a whole block in memory
+ */
+void writeTextBlock(int fd, GeneratorOptions *options, int infectedCount, Population *chunk, char *buffer, int first, int last, long long offset)
+{
+    for (int chunkStart = first; chunkStart < last; chunkStart += OUTPUT_CHUNK_PERSONS)
+    {
+        int chunkEnd = chunkStart + OUTPUT_CHUNK_PERSONS < last ? chunkStart + OUTPUT_CHUNK_PERSONS : last;
+        generateChunk(options, infectedCount, chunk, chunkStart, chunkEnd);
+        char *cursor = buffer;
+        for (int i = 0; i < chunkEnd - chunkStart; i++)
+            cursor = formatPerson(cursor, chunk, i, INPUT_PRINT_FORMAT);
+        if (pwrite(fd, buffer, cursor - buffer, offset) != cursor - buffer)
+        {
+            perror("File could not be written\n");
+            exit(1);
+        }
+        offset += cursor - buffer;
+    }
+}
 
+/**
+ * Generate the file: every thread takes a block of persons; for text the block offsets come from the lengths
+ * of the blocks before it, for a binary snapshot every array of a chunk goes directly at its place in the layout
+ */
+void generatePersons(GeneratorOptions *options)
+{
     // Calculate the number of persons that are initially infected
-    int infectedCount = (N * infectionPercentage) / 100;
+    int infectedCount = (int)((long long)options->N * options->infectionPercentage / 100);
     if (infectedCount < 1)
         infectedCount = 1; // Ensure at least one infected person
 
-    // generate the right number of infection statuses
-    int *statuses = malloc(N * sizeof(int));
-    for (int i = 0; i < infectedCount; i++)
+    size_t nameLength = strlen(options->filename);
+    int binary = nameLength >= strlen(BINARY_EXTENSION) && strcmp(options->filename + nameLength - strlen(BINARY_EXTENSION), BINARY_EXTENSION) == 0;
+
+    int fd = open(options->filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
     {
-        statuses[i] = 0; // infected person
+        printf("Error opening file\n");
+        exit(1);
     }
-    for (int i = infectedCount; i < N; i++)
+
+    SimulationData simulation = {options->maxX, options->maxY, options->N, 0, 0, INFECTED_DURATION, IMMUNE_DURATION};
+    size_t offsets[POPULATION_ARRAY_COUNT];
+    char header[MAX_LINE_LENGTH];
+    int headerLength = 0;
+    if (binary)
     {
-        statuses[i] = 1; // susceptible person
+        SnapshotHeader snapshotHeader;
+        initSnapshotHeader(&snapshotHeader, &simulation, 0);
+        if (pwrite(fd, &snapshotHeader, sizeof(snapshotHeader), 0) != sizeof(snapshotHeader) ||
+            ftruncate(fd, snapshotLayout(options->N, offsets)) != 0)
+        {
+            perror("File could not be written\n");
+            exit(1);
+        }
     }
-
-    // shuffle statuses array for randomization
-    for (int i = N - 1; i > 0; i--)
+    else
     {
-        int j = rand() % (i + 1);
-        int temp = statuses[i];
-        statuses[i] = statuses[j];
-        statuses[j] = temp;
+        headerLength = snprintf(header, sizeof(header), "%d %d\n%d\n", options->maxX, options->maxY, options->N); // grid sizes, number of persons
+        writeAll(fd, header, headerLength);
     }
 
-    
-    fprintf(file, "%d %d\n", maxX, maxY); // grid sizes 
+    long long *blockLength = calloc(options->threadCount, sizeof(long long));
+    if (!blockLength)
+    {
+        printf("Error allocating memory\n");
+        exit(1);
+    }
 
-    fprintf(file, "%d\n", N); // number of persons
-    for (int i = 0; i < N; i++)
+    #pragma omp parallel num_threads(options->threadCount)
     {
-        Person p;
-        p.personID = i + 1;
-        p.x = rand() % (maxX - 1); // x coordinate
-        p.y = rand() % (maxY - 1); // y coordinate
-        p.status = statuses[i];    // status from randomized array
+        int first, last;
+        threadRange(options->N, OUTPUT_CHUNK_PERSONS, &first, &last);
+        Population *chunk = allocPopulation(OUTPUT_CHUNK_PERSONS);
 
-        // movement direction and amplitude
-        p.direction = rand() % 4;                     // direction (0=N 1=S 2=E 3=W)
-        if ((p.direction == 0) || (p.direction == 1)) // N,S
-            p.amplitude = 1 + rand() % (maxY / 2);  //movement amplitude must be at least 1
-        else if ((p.direction == 2) || (p.direction == 3)) // E, W
-            p.amplitude = 1 + rand() % (maxX / 2);
+        if (binary)
+        {
+            void **arrays[POPULATION_ARRAY_COUNT];
+            populationArrays(chunk, arrays);
+            for (int chunkStart = first; chunkStart < last; chunkStart += OUTPUT_CHUNK_PERSONS)
+            {
+                int chunkEnd = chunkStart + OUTPUT_CHUNK_PERSONS < last ? chunkStart + OUTPUT_CHUNK_PERSONS : last;
+                generateChunk(options, infectedCount, chunk, chunkStart, chunkEnd);
+                for (int k = 0; k < POPULATION_ARRAY_COUNT; k++)
+                {
+                    size_t length = (size_t)(chunkEnd - chunkStart) * populationElementSize[k];
+                    if (pwrite(fd, *arrays[k], length, offsets[k] + (size_t)chunkStart * populationElementSize[k]) != (ssize_t)length)
+                    {
+                        perror("File could not be written\n");
+                        exit(1);
+                    }
+                }
+            }
+        }
+        else
+        {
+            char *buffer = malloc((size_t)OUTPUT_CHUNK_PERSONS * MAX_LINE_LENGTH);
+            if (!buffer)
+            {
+                printf("Error allocating memory\n");
+                exit(1);
+            }
+            int thread = omp_get_thread_num();
+            blockLength[thread] = measureTextBlock(options, infectedCount, chunk, buffer, first, last);
+            #pragma omp barrier
 
-        // write the data of one person on one line
-        fprintf(file, "%d %d %d %d %d %d\n",
-                p.personID, p.x, p.y, p.status, p.direction, p.amplitude);
+            long long offset = headerLength;
+            for (int t = 0; t < thread; t++)
+                offset += blockLength[t];
+            writeTextBlock(fd, options, infectedCount, chunk, buffer, first, last, offset);
+            free(buffer);
+        }
+
+        freePopulation(chunk);
     }
 
-    free(statuses);
-    fclose(file);
+    free(blockLength);
+    if (close(fd) != 0)
+    {
+        perror("File could not be closed\n");
+        exit(1);
+    }
 }
 
-int main()
+/**
+ * Create the output file name from the number of persons
+ */
+void defaultFilename(GeneratorOptions *options)
 {
-    srand(time(NULL));
-    int N, maxX, maxY, infectionPercentage;
+    if (options->N >= 1000000)
+    {
+        int millions = options->N / 1000000;
+        snprintf(options->filename, sizeof(options->filename), "epidemics%dM.txt", millions);
+    }
+    else if (options->N >= 1000)
+    {
+        int thousends = options->N / 1000;
+        snprintf(options->filename, sizeof(options->filename), "epidemics%dK.txt", thousends);
+    }
+    else
+    {
+        snprintf(options->filename, sizeof(options->filename), "epidemics%d.txt", options->N);
+    }
+}
 
+void readInteractive(GeneratorOptions *options)
+{
     printf("Enter value for max X coordinate: ");
-    scanf("%d", &maxX);
+    if (scanf("%d", &options->maxX) != 1)
+        exit(1);
     printf("Enter value for max Y coordinate: ");
-    scanf("%d", &maxY);
+    if (scanf("%d", &options->maxY) != 1)
+        exit(1);
 
-    printf("On your grid there are %d points \n", maxX * maxY);
+    printf("On your grid there are %lld points \n", (long long)options->maxX * options->maxY);
 
     printf("Enter the number of persons: ");
-    scanf("%d", &N);
+    if (scanf("%d", &options->N) != 1)
+        exit(1);
 
-    if (N <= 0)
-    {
-        printf("The number of persons must be >=0 \n");
+    printf("Enter the percentage of initially infected persons (0-100): ");
+    if (scanf("%d", &options->infectionPercentage) != 1)
         exit(1);
+
+    options->seed = (uint64_t)time(NULL);
+    options->threadCount = omp_get_max_threads();
+    options->mode = MODE_UNIFORM;
+    options->groups = DEFAULT_GROUPS;
+    options->spread = 0;
+    options->alpha = DEFAULT_ALPHA;
+    defaultFilename(options);
+}
+
+void parseGeneratorOptions(int argc, const char *argv[], GeneratorOptions *options)
+{
+    if (argc < GENERATOR_ARGUMENT_COUNT)
+        generatorUsage();
+
+    options->maxX = atoi(argv[1]);
+    options->maxY = atoi(argv[2]);
+    options->N = atoi(argv[3]);
+    options->infectionPercentage = atoi(argv[4]);
+    options->seed = DEFAULT_SEED;
+    options->threadCount = omp_get_max_threads();
+    options->filename[0] = '\0';
+    options->mode = MODE_UNIFORM;
+    options->groups = DEFAULT_GROUPS;
+    options->spread = 0; // 0 = chosen from the grid size in main
+    options->alpha = DEFAULT_ALPHA;
+
+    for (int i = GENERATOR_ARGUMENT_COUNT; i < argc; i++)
+    {
+        if (strncmp(argv[i], SEED_OPTION, strlen(SEED_OPTION)) == 0)
+            options->seed = strtoull(argv[i] + strlen(SEED_OPTION), NULL, 10);
+        else if (strncmp(argv[i], THREADS_OPTION, strlen(THREADS_OPTION)) == 0)
+        {
+            options->threadCount = atoi(argv[i] + strlen(THREADS_OPTION));
+            if (options->threadCount <= 0)
+                generatorUsage();
+        }
+        else if (strncmp(argv[i], OUTPUT_OPTION, strlen(OUTPUT_OPTION)) == 0)
+        {
+            if (strlen(argv[i] + strlen(OUTPUT_OPTION)) >= sizeof(options->filename))
+                generatorUsage();
+            strcpy(options->filename, argv[i] + strlen(OUTPUT_OPTION));
+        }
+        else if (strncmp(argv[i], MODE_OPTION, strlen(MODE_OPTION)) == 0)
+        {
+            const char *mode = argv[i] + strlen(MODE_OPTION);
+            if (strcmp(mode, "uniform") == 0)
+                options->mode = MODE_UNIFORM;
+            else if (strcmp(mode, "clusters") == 0)
+                options->mode = MODE_CLUSTERS;
+            else if (strcmp(mode, "powerlaw") == 0)
+                options->mode = MODE_POWERLAW;
+            else if (strcmp(mode, "corridor") == 0)
+                options->mode = MODE_CORRIDOR;
+            else
+                generatorUsage();
+        }
+        else if (strncmp(argv[i], GROUPS_OPTION, strlen(GROUPS_OPTION)) == 0)
+        {
+            options->groups = atoi(argv[i] + strlen(GROUPS_OPTION));
+            if (options->groups <= 0)
+                generatorUsage();
+        }
+        else if (strncmp(argv[i], SPREAD_OPTION, strlen(SPREAD_OPTION)) == 0)
+        {
+            options->spread = atof(argv[i] + strlen(SPREAD_OPTION));
+            if (options->spread <= 0)
+                generatorUsage();
+        }
+        else if (strncmp(argv[i], ALPHA_OPTION, strlen(ALPHA_OPTION)) == 0)
+        {
+            options->alpha = atof(argv[i] + strlen(ALPHA_OPTION));
+            if (options->alpha <= 0)
+                generatorUsage();
+        }
+        else
+            generatorUsage();
     }
 
-    printf("Enter the percentage of initially infected persons (0-100): ");
-    scanf("%d", &infectionPercentage);
+    if (options->filename[0] == '\0')
+        defaultFilename(options);
+}
 
-    if (infectionPercentage < 0 || infectionPercentage > 100)
+void generatorUsage()
+{
+    printf("Program call should be: ./generator maxX maxY N infectionPercentage [options], or ./generator to enter the values interactively\n");
+    printf("Options:\n");
+    printf("  %sS        seed of the random numbers (default %d); the same seed gives the same file for any number of threads\n", SEED_OPTION, DEFAULT_SEED);
+    printf("  %sT     threads that generate and write the persons (default all processors)\n", THREADS_OPTION);
+    printf("  %suniform|clusters|powerlaw|corridor   placement of the persons (default uniform)\n", MODE_OPTION);
+    printf("  %sK      hotspots of clusters, corridors of corridor (default %d)\n", GROUPS_OPTION, DEFAULT_GROUPS);
+    printf("  %sS      sigma of a hotspot / width of a corridor, in cells (default 1/50 of the smaller grid side, at least 1)\n", SPREAD_OPTION);
+    printf("  %sA       exponent of powerlaw: the k-th most crowded cell gets persons proportional to 1 / k^A (default %.1f)\n",
+           ALPHA_OPTION, DEFAULT_ALPHA);
+    printf("  %spath   output file (default epidemicsNK.txt / epidemicsNM.txt); a path ending in %s is written as a binary snapshot\n",
+           OUTPUT_OPTION, BINARY_EXTENSION);
+    exit(1);
+}
+
+int main(int argc, const char *argv[])
+{
+    GeneratorOptions options;
+    if (argc == 1)
+        readInteractive(&options);
+    else
+        parseGeneratorOptions(argc, argv, &options);
+
+    if (options.maxX < 2 || options.maxY < 2 || options.maxX > MAX_GRID_SIZE || options.maxY > MAX_GRID_SIZE)
     {
-        printf("Infection percentage must be between 0 and 100 !\n");
+        printf("The grid sizes must be between 2 and %d !\n", MAX_GRID_SIZE);
         exit(1);
     }
-
-    // Create the output file name 
-    char filename[30];
-    if (N >= 1000000)
+    if (options.N <= 0)
     {
-        int millions = N / 1000000;
-        snprintf(filename, sizeof(filename), "epidemics%dM.txt", millions);
+        printf("The number of persons must be >0 \n");
+        exit(1);
     }
-    else if (N >= 1000)
+    if (options.infectionPercentage < 0 || options.infectionPercentage > 100)
     {
-        int thousends = N / 1000;
-        snprintf(filename, sizeof(filename), "epidemics%dK.txt", thousends);
+        printf("Infection percentage must be between 0 and 100 !\n");
+        exit(1);
     }
-    else
+    if (options.spread <= 0)
     {
-        snprintf(filename, sizeof(filename), "epidemics%d.txt", N);
+        int side = options.maxX < options.maxY ? options.maxX : options.maxY;
+        options.spread = side / 50 > 1 ? side / 50 : 1;
     }
 
-    generatePersons(filename, N, maxX, maxY, infectionPercentage);
-    printf("Simulation data generated in file %s\n", filename);
+    double start = omp_get_wtime();
+    generatePersons(&options);
+    printf("Simulation data generated in file %s (seed %llu, %d threads, %.3f s)\n", options.filename, (unsigned long long)options.seed,
+           options.threadCount, omp_get_wtime() - start);
 
     return 0;
 }
@@ -0,0 +1,1187 @@
+#define _GNU_SOURCE // memfd_create
+#include "epidemics.h"
+
+const size_t populationElementSize[POPULATION_ARRAY_COUNT] = {
+    sizeof(int), sizeof(coord_t), sizeof(coord_t), sizeof(uint8_t), sizeof(uint8_t), sizeof(uint8_t), sizeof(uint8_t), sizeof(coord_t), sizeof(int)
+};
+
+Checkpointer *createCheckpointer(const char *inputPath, char *suffix, int every, SimulationData *simulation) {
+    Checkpointer *checkpointer = malloc(sizeof(Checkpointer));
+    if(!checkpointer) {
+        printf("Eroare la alocare checkpoint\n");
+        exit(-1);
+    }
+
+    checkpointer->path = buildOutputPath(inputPath, suffix);
+    checkpointer->temporaryPath = malloc(strlen(checkpointer->path) + strlen(TEMPORARY_SUFFIX) + 1);
+    if(!checkpointer->temporaryPath) {
+        printf("Eroare la alocare checkpoint\n");
+        exit(-1);
+    }
+    strcpy(checkpointer->temporaryPath, checkpointer->path);
+    strcat(checkpointer->temporaryPath, TEMPORARY_SUFFIX);
+
+    checkpointer->every = every;
+    checkpointer->copy = allocPopulation(simulation->numberOfPersons);
+    checkpointer->simulation = *simulation;
+    checkpointer->writing = 0;
+
+    return checkpointer;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Start Checkpoint
+ * Purpose:   Copy the state of population at step simulation->startStep and start a thread that writes it; the simulation
+            only waits for the copy, and for the previous checkpoint if it is still being written
+ * In args:   checkpointer, population, simulation
+ */
+void startCheckpoint(Checkpointer *checkpointer, Population *population, SimulationData *simulation) {
+    finishCheckpoint(checkpointer);
+
+    copyPopulation(checkpointer->copy, population, simulation->numberOfPersons);
+    checkpointer->simulation = *simulation;
+    checkpointer->simulation.simulationTime = simulation->startStep;
+
+    if(pthread_create(&checkpointer->writer, NULL, checkpointWriter, checkpointer) != 0) {
+        printf("Thread-ul pentru checkpoint nu a putut fi creat\n");
+        exit(-1);
+    }
+    checkpointer->writing = 1;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Checkpoint Writer
+ * Purpose:   Thread function: write the copy of the checkpointer in a temporary file and rename it over the checkpoint,
+            so a run stopped in the middle of a write still has the previous checkpoint
+ * In args:   argument (the checkpointer)
+ */
+void *checkpointWriter(void *argument) {
+    Checkpointer *checkpointer = argument;
+
+    saveSnapshot(checkpointer->temporaryPath, checkpointer->copy, &checkpointer->simulation, checkpointer->simulation.simulationTime);
+    if(rename(checkpointer->temporaryPath, checkpointer->path) != 0) {
+        perror("Checkpoint could not be renamed\n");
+        exit(-1);
+    }
+
+    return NULL;
+}
+
+void finishCheckpoint(Checkpointer *checkpointer) {
+    if(checkpointer->writing) {
+        pthread_join(checkpointer->writer, NULL);
+        checkpointer->writing = 0;
+    }
+}
+
+void freeCheckpointer(Checkpointer *checkpointer) {
+    finishCheckpoint(checkpointer);
+    freePopulation(checkpointer->copy);
+    free(checkpointer->path);
+    free(checkpointer->temporaryPath);
+    free(checkpointer);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Resume From Checkpoint
+ * Purpose:   If the checkpoint of inputPath with suffix exists, replace population with the state saved in it and continue
+            the simulation from its step; a checkpoint of another input or one after simulationTime is ignored
+ * In args:   inputPath, suffix, population, simulation, name (of the version, for messages)
+ */
+void resumeFromCheckpoint(const char *inputPath, char *suffix, Population **population, SimulationData *simulation, const char *name) {
+    char *checkpointPath = buildOutputPath(inputPath, suffix);
+
+    if(access(checkpointPath, R_OK) != 0) {
+        printf("%s: no checkpoint, starting from step %d\n", name, simulation->startStep);
+        free(checkpointPath);
+        return;
+    }
+
+    SimulationData checkpointSimulation;
+    Population *checkpoint = loadPopulation(checkpointPath, &checkpointSimulation, 1);
+
+    if(checkpointSimulation.maxXCoord != simulation->maxXCoord || checkpointSimulation.maxYCoord != simulation->maxYCoord ||
+       checkpointSimulation.numberOfPersons != simulation->numberOfPersons) {
+        printf("%s: checkpoint %s is for another input, ignored\n", name, checkpointPath);
+        freePopulation(checkpoint);
+    } else if(checkpointSimulation.startStep > simulation->simulationTime) {
+        printf("%s: checkpoint %s is at step %d, after simulationTime, ignored\n", name, checkpointPath, checkpointSimulation.startStep);
+        freePopulation(checkpoint);
+    } else {
+        printf("%s: resuming from step %d\n", name, checkpointSimulation.startStep);
+        freePopulation(*population);
+        *population = checkpoint;
+        simulation->startStep = checkpointSimulation.startStep;
+    }
+
+    free(checkpointPath);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Open Statistics
+ * Purpose:   Create the statistics file at path and write its header: the CSV column names, or a StatisticsHeader for the binary format
+ * In args:   path, format, simulation
+ */
+StatisticsStream *openStatistics(const char *path, int format, SimulationData *simulation) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) {
+        printf("File not found!\n");
+        exit(-1);
+    }
+
+    return streamStatistics(fd, format, simulation);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Stream Statistics
+ * Purpose:   Like openStatistics, on a file that is already open (the file is not closed by releaseStatistics)
+ * In args:   fd, format, simulation
+ */
+StatisticsStream *streamStatistics(int fd, int format, SimulationData *simulation) {
+    char error[LOAD_ERROR_LENGTH];
+    StatisticsStream *statistics = tryStreamStatistics(fd, format, simulation, error);
+    if(!statistics) {
+        printf("%s\n", error);
+        exit(-1);
+    }
+    statistics->keepErrors = 0;
+    return statistics;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Try Stream Statistics
+ * Purpose:   streamStatistics that gives back its error (no memory, or the header could not be written) instead of stopping
+            the program; the stream it returns does not stop the program either when a write fails: the error is kept in
+            writeError, the steps after it are dropped, and tryReleaseStatistics gives it back
+ * In args:   fd, format, simulation
+ * Out args:  error (LOAD_ERROR_LENGTH characters)
+ * Return:    the stream, or NULL
+ */
+StatisticsStream *tryStreamStatistics(int fd, int format, SimulationData *simulation, char *error) {
+    StatisticsStream *statistics = malloc(sizeof(StatisticsStream));
+    if(!statistics) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Eroare la alocare statistici");
+        return NULL;
+    }
+    statistics->format = format;
+    statistics->stepCount = 0;
+    statistics->keepErrors = 1;
+    statistics->writeError = 0;
+    statistics->steps = malloc(STATISTICS_BUFFER_STEPS * sizeof(StepStatistics));
+    statistics->text = format == STATISTICS_CSV ? malloc(STATISTICS_BUFFER_STEPS * MAX_LINE_LENGTH) : NULL;
+    if(!statistics->steps || (format == STATISTICS_CSV && !statistics->text)) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Eroare la alocare statistici");
+        free(statistics->steps);
+        free(statistics->text);
+        free(statistics);
+        return NULL;
+    }
+
+    statistics->fd = fd;
+
+    if(format == STATISTICS_BINARY) {
+        StatisticsHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, STATISTICS_MAGIC, sizeof(header.magic));
+        header.version = STATISTICS_VERSION;
+        header.headerSize = sizeof(StatisticsHeader);
+        header.recordSize = sizeof(StepStatistics);
+        header.maxXCoord = simulation->maxXCoord;
+        header.maxYCoord = simulation->maxYCoord;
+        header.numberOfPersons = simulation->numberOfPersons;
+        writeStatistics(statistics, &header, sizeof(header));
+    } else {
+        writeStatistics(statistics, STATISTICS_CSV_HEADER, strlen(STATISTICS_CSV_HEADER));
+    }
+    if(statistics->writeError != 0) {
+        tryReleaseStatistics(statistics, error);
+        return NULL;
+    }
+
+    return statistics;
+}
+
+// scrie in fisierul statisticilor; dupa o scriere esuata a unui stream care pastreaza erorile nu mai scrie nimic
+void writeStatistics(StatisticsStream *statistics, const void *buffer, size_t size) {
+    if(statistics->writeError != 0) return;
+    if(tryWriteAll(statistics->fd, buffer, size) != 0) {
+        if(!statistics->keepErrors) {
+            perror("File could not be written\n");
+            exit(-1);
+        }
+        statistics->writeError = errno;
+    }
+}
+
+void recordStep(StatisticsStream *statistics, StepStatistics *step) {
+    statistics->steps[statistics->stepCount++] = *step;
+    if(statistics->stepCount == STATISTICS_BUFFER_STEPS) {
+        flushStatistics(statistics);
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Flush Statistics
+ * Purpose:   Write the steps gathered since the last flush with a single write
+ * In args:   statistics
+ */
+void flushStatistics(StatisticsStream *statistics) {
+    if(statistics->stepCount == 0) return;
+
+    if(statistics->format == STATISTICS_BINARY) {
+        writeStatistics(statistics, statistics->steps, (size_t)statistics->stepCount * sizeof(StepStatistics));
+    } else {
+        char *cursor = statistics->text;
+        for(int k=0;k<statistics->stepCount;k++) {
+            StepStatistics *step = &statistics->steps[k];
+            int values[] = {step->step, step->infected, step->susceptible, step->immune, step->newInfections, step->occupiedCells, step->maxCellOccupancy};
+            for(int v=0;v<(int)(sizeof(values) / sizeof(values[0]));v++) {
+                if(v > 0) *cursor++ = ',';
+                cursor = formatInt(cursor, values[v]);
+            }
+            *cursor++ = '\n';
+        }
+        writeStatistics(statistics, statistics->text, cursor - statistics->text);
+    }
+    statistics->stepCount = 0;
+}
+
+void closeStatistics(StatisticsStream *statistics) {
+    int fd = statistics->fd;
+    releaseStatistics(statistics);
+    if(close(fd) != 0) {
+        perror("File could not be closed\n");
+        exit(-1);
+    }
+}
+
+// scrie pasii ramasi si elibereaza statisticile, fara sa inchida fisierul
+void releaseStatistics(StatisticsStream *statistics) {
+    char error[LOAD_ERROR_LENGTH];
+    if(tryReleaseStatistics(statistics, error) != 0) {
+        printf("%s\n", error);
+        exit(-1);
+    }
+}
+
+// releaseStatistics care intoarce -1 si eroarea daca o scriere a stream-ului a esuat
+int tryReleaseStatistics(StatisticsStream *statistics, char *error) {
+    flushStatistics(statistics);
+    int writeError = statistics->writeError;
+    free(statistics->steps);
+    free(statistics->text);
+    free(statistics);
+    if(writeError != 0) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Statisticile nu au putut fi scrise: %s", strerror(writeError));
+        return -1;
+    }
+    return 0;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Write Output
+ * Purpose:   Write the state of all persons in the file at outputPath, in one of the text formats or as a binary snapshot
+            of the step the simulation stopped at
+ * In args:   outputPath, population, simulation, format
+ */
+void writeOutput(const char *outputPath, Population *population, SimulationData *simulation, int format) {
+    if(format == BINARY_SNAPSHOT_FORMAT) {
+        saveSnapshot(outputPath, population, simulation, simulation->simulationTime);
+        return;
+    }
+
+    int outputFile = open(outputPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(outputFile < 0) {
+        printf("File not found!\n");
+        exit(-1);
+    }
+
+    if(format == INPUT_PRINT_FORMAT) {
+        char header[64];
+        int length = snprintf(header, sizeof(header), "%d %d\n%d\n", simulation->maxXCoord, simulation->maxYCoord, simulation->numberOfPersons);
+        writeAll(outputFile, header, length);
+    }
+    personPrintToFile(outputFile, population, simulation, format);
+
+    if(close(outputFile) != 0) {
+        perror("File could not be closed\n");
+        exit(-1);
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Load Population
+ * Purpose:   Read the simulation data and the persons from path, which can be a text input file or a binary snapshot;
+            a snapshot is used in place, from the memory mapping of the file
+ * In args:   path, threadCount
+ * Out args:  simulation
+ */
+Population *loadPopulation(const char *path, SimulationData *simulation, int threadCount) {
+    char error[LOAD_ERROR_LENGTH];
+    Population *population = tryLoadPopulation(path, simulation, threadCount, error);
+    if(!population) {
+        printf("%s\n", error);
+        exit(-1);
+    }
+
+    return population;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Try Load Population
+ * Purpose:   loadPopulation for a program that must keep running after a bad input (the server): every error of the file is
+            returned instead of stopping the program
+ * In args:   path, threadCount
+ * Out args:  simulation, error (LOAD_ERROR_LENGTH characters, the reason if the population could not be loaded)
+ * Return:    the population, or NULL
+ */
+Population *tryLoadPopulation(const char *path, SimulationData *simulation, int threadCount, char *error) {
+    InputFile inputFile;
+    if(tryOpenInputFile(path, &inputFile, error) != 0) return NULL;
+    Population *population = NULL;
+
+    if(isSnapshot(&inputFile)) {
+        population = tryLoadSnapshot(&inputFile, simulation, error);
+    } else if(trySimulationScan(&inputFile, simulation, error) == 0) {
+        population = tryAllocPopulation(simulation->numberOfPersons);
+        if(!population) {
+            snprintf(error, LOAD_ERROR_LENGTH, "Eroare la alocare populatie de %d persoane", simulation->numberOfPersons);
+        } else if(tryPersonScan(&inputFile, population, simulation, threadCount, error) != 0) {
+            freePopulation(population);
+            population = NULL;
+        }
+    }
+
+    closeInputFile(&inputFile);
+    return population;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Open Input File
+ * Purpose:   Map the whole input file in memory (private copy on write), so it can be parsed or used in place, without copies and without stdio
+ * In args:   path
+ */
+InputFile openInputFile(const char *path) {
+    InputFile input;
+    char error[LOAD_ERROR_LENGTH];
+    if(tryOpenInputFile(path, &input, error) != 0) {
+        printf("%s\n", error);
+        exit(-1);
+    }
+
+    return input;
+}
+
+// openInputFile care intoarce -1 si motivul in error in loc sa opreasca programul
+int tryOpenInputFile(const char *path, InputFile *input, char *error) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        snprintf(error, LOAD_ERROR_LENGTH, "File not found!");
+        return -1;
+    }
+
+    int result = tryMapInputFile(fd, input, error);
+    close(fd);
+    return result;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Map Input File
+ * Purpose:   Map the whole file open at fd like openInputFile; every mapping of the same fd is a separate private copy on write,
+            so several populations can start from one file and only copy the pages they change
+ * In args:   fd (stays open)
+ */
+InputFile mapInputFile(int fd) {
+    InputFile input;
+    char error[LOAD_ERROR_LENGTH];
+    if(tryMapInputFile(fd, &input, error) != 0) {
+        printf("%s\n", error);
+        exit(-1);
+    }
+
+    return input;
+}
+
+// mapInputFile care intoarce -1 si motivul in error in loc sa opreasca programul
+int tryMapInputFile(int fd, InputFile *input, char *error) {
+    *input = (InputFile){NULL, 0, 0, 1};
+
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) != 0) {
+        snprintf(error, LOAD_ERROR_LENGTH, "File could not be read: %s", strerror(errno));
+        return -1;
+    }
+
+    input->size = fileStat.st_size;
+    if(input->size > 0) {
+        // copy on write: un snapshot binar e folosit direct ca array-urile populatiei si e modificat de simulare
+        void *data = mmap(NULL, input->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if(data == MAP_FAILED) {
+            snprintf(error, LOAD_ERROR_LENGTH, "File could not be mapped: %s", strerror(errno));
+            input->size = 0;
+            return -1;
+        }
+        madvise(data, input->size, MADV_SEQUENTIAL);
+        input->data = data;
+    }
+
+    return 0;
+}
+
+void closeInputFile(InputFile *input) {
+    if(input->data) {
+        munmap((void *)input->data, input->size);
+    }
+    input->data = NULL;
+    input->size = 0;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Set Durations
+ * Purpose:   Use other durations of the infected and immune statuses than INFECTED_DURATION and IMMUNE_DURATION; at step 0 the
+            persons infected from the start get the new infected duration (like initPerson), later the persons already infected
+            or immune keep the time they have left
+ * In args:   infectedDuration, immuneDuration (1 .. UINT8_MAX, statusDuration has one byte)
+ * Out args:  population (can be NULL), simulation
+ */
+void setDurations(Population *population, SimulationData *simulation, int infectedDuration, int immuneDuration) {
+    if(infectedDuration < 1 || infectedDuration > UINT8_MAX || immuneDuration < 1 || immuneDuration > UINT8_MAX) {
+        printf("Duratele trebuie sa fie intre 1 si %d (infectat %d, imun %d)\n", UINT8_MAX, infectedDuration, immuneDuration);
+        exit(-1);
+    }
+
+    if(population && simulation->startStep == 0 && infectedDuration != simulation->infectedDuration) {
+        for(int i=0;i<simulation->numberOfPersons;i++) {
+            // doar paginile cu infectati sunt scrise, restul raman comune daca populatia e o copie privata
+            if(population->status[i] == INFECTED) {
+                population->statusDuration[i] = infectedDuration;
+            }
+        }
+    }
+    simulation->infectedDuration = infectedDuration;
+    simulation->immuneDuration = immuneDuration;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Simulation Scan
+ * Purpose:   Read the fields of simulation given at the start of the input file (maxXCoords, maxYCoords, numberOfPersons)
+            and move the input position after them
+ * In args:   input, simulation
+ */
+void simulationScan(InputFile *input, SimulationData *simulation) {
+    char error[LOAD_ERROR_LENGTH];
+    if(trySimulationScan(input, simulation, error) != 0) {
+        printf("%s\n", error);
+        exit(-1);
+    }
+}
+
+// simulationScan care intoarce -1 si motivul in error in loc sa opreasca programul
+int trySimulationScan(InputFile *input, SimulationData *simulation, char *error) {
+    const char *cursor = input->data;
+    const char *end = input->data + input->size;
+    int values[3];
+    int found = 0;
+
+    // antetul e "maxX maxY" pe o linie si numberOfPersons pe urmatoarea, dar accept orice impartire pe linii
+    while(found < 3 && cursor < end) {
+        const char *nextLine;
+        int count = parseLine(cursor, end, values + found, 3 - found, &nextLine);
+        if(count < 0) {
+            snprintf(error, LOAD_ERROR_LENGTH, "Linia %d: antet invalid, se asteapta \"maxX maxY\" si apoi numarul de persoane", input->line);
+            return -1;
+        }
+        found += count;
+        cursor = nextLine;
+        input->line++;
+    }
+
+    if(found < 3) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Fisierul de intrare nu are antet complet (maxX maxY numberOfPersons)");
+        return -1;
+    }
+
+    simulation->maxXCoord = values[0];
+    simulation->maxYCoord = values[1];
+    simulation->numberOfPersons = values[2];
+    simulation->startStep = 0;
+    simulation->infectedDuration = INFECTED_DURATION;
+    simulation->immuneDuration = IMMUNE_DURATION;
+    input->position = cursor - input->data;
+
+    if(simulation->maxXCoord <= 0 || simulation->maxYCoord <= 0) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Dimensiune invalida pentru grid: %d x %d", simulation->maxXCoord, simulation->maxYCoord);
+        return -1;
+    }
+    if(simulation->numberOfPersons < 0) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Numar invalid de persoane: %d", simulation->numberOfPersons);
+        return -1;
+    }
+    if(simulation->maxXCoord > MAX_GRID_SIZE || simulation->maxYCoord > MAX_GRID_SIZE) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Grid-ul %d x %d depaseste %d pe o axa - compilati cu WIDE_COORDINATES", simulation->maxXCoord,
+                 simulation->maxYCoord, MAX_GRID_SIZE);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Person Scan
+ * Purpose:   Input data into the population from the rows of the mapped input file and validate them. Also updates the status of
+            every person read in order to initialize both status and nextStatus. The rows are split between threadCount threads
+            at line boundaries: every thread counts the rows in its part, the counts give the index of its first person, then every thread
+            parses its part in place. Malformed rows, values out of the grid and a wrong number of rows are reported and stop the program
+ * In args:   input, population, simulation, threadCount
+ */
+void personScan(InputFile *input, Population *population, SimulationData *simulation, int threadCount) {
+    char error[LOAD_ERROR_LENGTH];
+    if(tryPersonScan(input, population, simulation, threadCount, error) != 0) {
+        printf("%s\n", error);
+        exit(-1);
+    }
+}
+
+// personScan care intoarce -1 si prima eroare in error in loc sa opreasca programul
+int tryPersonScan(InputFile *input, Population *population, SimulationData *simulation, int threadCount, char *error) {
+    const char *begin = input->data + input->position;
+    const char *end = input->data + input->size;
+    size_t size = end - begin;
+
+    // nu merita sa impart intre thread-uri fisiere mici
+    if(size < (size_t)threadCount * 4096) threadCount = 1;
+
+    int *rowCount = calloc(threadCount + 1, sizeof(int));
+    int *lineCount = calloc(threadCount + 1, sizeof(int));
+    InputErrors *errors = calloc(threadCount, sizeof(InputErrors));
+    if(!rowCount || !lineCount || !errors) {
+        free(rowCount);
+        free(lineCount);
+        free(errors);
+        snprintf(error, LOAD_ERROR_LENGTH, "Eroare la alocare pentru citire");
+        return -1;
+    }
+
+    #pragma omp parallel num_threads(threadCount)
+    {
+        int threadID = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+
+        // partea thread-ului incepe dupa primul '\n' de la pozitia lui, ca sa nu taie o linie in doua
+        const char *partStart = begin + size * threadID / threads;
+        const char *partEnd = begin + size * (threadID + 1) / threads;
+        if(threadID > 0) {
+            const char *newLine = memchr(partStart - 1, '\n', end - partStart + 1);
+            partStart = newLine ? newLine + 1 : end;
+        }
+        if(threadID < threads - 1) {
+            const char *newLine = memchr(partEnd - 1, '\n', end - partEnd + 1);
+            partEnd = newLine ? newLine + 1 : end;
+        } else {
+            partEnd = end;
+        }
+
+        int rows = 0, lines = 0;
+        for(const char *cursor=partStart;cursor<partEnd;lines++) {
+            const char *newLine = memchr(cursor, '\n', partEnd - cursor);
+            const char *lineEnd = newLine ? newLine : partEnd;
+            while(cursor < lineEnd && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')) cursor++;
+            if(cursor < lineEnd) rows++;
+            cursor = newLine ? newLine + 1 : partEnd;
+        }
+        rowCount[threadID + 1] = rows;
+        lineCount[threadID + 1] = lines;
+        #pragma omp barrier
+
+        #pragma omp single
+        {
+            for(int t=0;t<threads;t++) {
+                rowCount[t + 1] += rowCount[t];
+                lineCount[t + 1] += lineCount[t];
+            }
+        }
+
+        int index = rowCount[threadID];
+        int line = input->line + lineCount[threadID];
+        int values[PERSON_FIELD_COUNT];
+        char rowError[INPUT_ERROR_LENGTH];
+        for(const char *cursor=partStart;cursor<partEnd;line++) {
+            const char *nextLine;
+            int count = parseLine(cursor, partEnd, values, PERSON_FIELD_COUNT, &nextLine);
+            cursor = nextLine;
+            if(count == 0) continue;
+
+            if(count != PERSON_FIELD_COUNT) {
+                snprintf(rowError, sizeof(rowError), "rand invalid, se asteapta %d numere intregi", PERSON_FIELD_COUNT);
+                addInputError(&errors[threadID], line, rowError);
+            } else if(checkRow(values, simulation, rowError) != 0) {
+                addInputError(&errors[threadID], line, rowError);
+            } else if(index < simulation->numberOfPersons) {
+                initPerson(population, index, values, simulation);
+            }
+            index++;
+        }
+    }
+
+    InputErrors *first = NULL;
+    int errorCount = 0;
+    for(int t=0;t<threadCount;t++) {
+        errorCount += errors[t].errorCount;
+        if(errors[t].errorCount > 0 && (!first || errors[t].firstErrorLine < first->firstErrorLine)) {
+            first = &errors[t];
+        }
+    }
+    int result = -1;
+    if(first) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Linia %d: %s (fisierul de intrare are %d randuri invalide)", first->firstErrorLine, first->firstError,
+                 errorCount);
+    } else if(rowCount[threadCount] != simulation->numberOfPersons) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Fisierul de intrare are %d randuri cu persoane, dar antetul anunta %d", rowCount[threadCount],
+                 simulation->numberOfPersons);
+    } else {
+        result = 0;
+    }
+
+    free(rowCount);
+    free(lineCount);
+    free(errors);
+    return result;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Init Person
+ * Purpose:   Set the person at index from the PERSON_FIELD_COUNT values of a checked input row; an infected person starts
+            with the full infectedDuration and one infection
+ * In args:   population, index, values, simulation
+ */
+void initPerson(Population *population, int index, const int *values, SimulationData *simulation) {
+    population->personID[index] = values[0];
+    population->x[index] = values[1];
+    population->y[index] = values[2];
+    population->nextStatus[index] = values[3];
+    population->movementDirection[index] = values[4];
+    population->movementAmplitude[index] = values[5];
+    population->infectionCounter[index] = 0;
+    population->statusDuration[index] = 0;
+
+    updateStatus(population, index, simulation);
+    if(population->status[index] == INFECTED) {
+        population->statusDuration[index]++;
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Parse Line
+ * Purpose:   Parse the integers of the line that starts at cursor, without stdio; spaces, tabs and '\r' separate the numbers
+ * In args:   cursor, end, maxValues
+ * Out args:  values, nextLine (the start of the next line)
+ * Return:    how many integers the line has (0 for an empty line), or -1 if it has anything else or more than maxValues integers
+ */
+int parseLine(const char *cursor, const char *end, int *values, int maxValues, const char **nextLine) {
+    int count = 0;
+    int malformed = 0;
+
+    while(1) {
+        while(cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')) cursor++;
+        if(cursor == end || *cursor == '\n') break;
+
+        int negative = 0;
+        if(*cursor == '-' || *cursor == '+') {
+            negative = *cursor == '-';
+            cursor++;
+        }
+
+        long long value = 0;
+        const char *digits = cursor;
+        while(cursor < end && *cursor >= '0' && *cursor <= '9' && value <= INT_MAX) {
+            value = value * 10 + (*cursor - '0');
+            cursor++;
+        }
+
+        int separated = cursor == end || *cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n';
+        if(cursor == digits || !separated || value > INT_MAX || count == maxValues) {
+            malformed = 1;
+            break;
+        }
+        values[count++] = negative ? (int)-value : (int)value;
+    }
+
+    const char *newLine = cursor < end ? memchr(cursor, '\n', end - cursor) : NULL;
+    *nextLine = newLine ? newLine + 1 : end;
+
+    return malformed ? -1 : count;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Check Row
+ * Purpose:   Check that the values of a person row fit in the simulation: coordinates inside the grid, a known status and direction,
+            and an amplitude that fits in coord_t
+ * In args:   values, simulation
+ * Out args:  error (the reason, if the row is not valid)
+ * Return:    0 if the row is valid, -1 otherwise
+ */
+int checkRow(const int *values, SimulationData *simulation, char *error) {
+    if(values[1] < 0 || values[1] >= simulation->maxXCoord || values[2] < 0 || values[2] >= simulation->maxYCoord) {
+        snprintf(error, INPUT_ERROR_LENGTH, "coordonatele (%d, %d) sunt in afara grid-ului %d x %d", values[1], values[2], simulation->maxXCoord, simulation->maxYCoord);
+        return -1;
+    }
+    if(values[3] != INFECTED && values[3] != SUSCEPTIBLE && values[3] != IMMUNE) {
+        snprintf(error, INPUT_ERROR_LENGTH, "status necunoscut %d", values[3]);
+        return -1;
+    }
+    if(values[4] < NORTH || values[4] > WEST) {
+        snprintf(error, INPUT_ERROR_LENGTH, "directie necunoscuta %d", values[4]);
+        return -1;
+    }
+    if(values[5] < 0 || values[5] > MAX_GRID_SIZE) {
+        snprintf(error, INPUT_ERROR_LENGTH, "amplitudine invalida %d", values[5]);
+        return -1;
+    }
+
+    return 0;
+}
+
+void addInputError(InputErrors *errors, int line, const char *error) {
+    if(errors->errorCount == 0) {
+        errors->firstErrorLine = line;
+        snprintf(errors->firstError, INPUT_ERROR_LENGTH, "%s", error);
+    }
+    errors->errorCount++;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Person Print To File
+ * Purpose:   Output data for all persons into a file, with the same bytes as fprintf would write, but without stdio: the persons are
+            taken in rounds of one chunk of OUTPUT_CHUNK_PERSONS per thread, every thread formats its chunk in its own buffer, and then
+            the buffers of the round are written in order, each with one large write
+ * In args:   fd, population, simulation, format
+ */
+void personPrintToFile(int fd, Population *population, SimulationData *simulation, int format) {
+    char error[LOAD_ERROR_LENGTH];
+    if(tryPersonPrintToFile(fd, population, simulation, format, error) != 0) {
+        printf("%s\n", error);
+        exit(-1);
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Try Person Print To File
+ * Purpose:   personPrintToFile that gives back its error instead of stopping the program: the buffers that could not be allocated
+            or the first write that failed (the rounds after it are still formatted, but not written)
+ * In args:   fd, population, simulation, format
+ * Out args:  error (LOAD_ERROR_LENGTH characters)
+ * Return:    0, or -1
+ */
+int tryPersonPrintToFile(int fd, Population *population, SimulationData *simulation, int format, char *error) {
+    int threadCount = omp_get_max_threads();
+    int chunkCount = (simulation->numberOfPersons + OUTPUT_CHUNK_PERSONS - 1) / OUTPUT_CHUNK_PERSONS;
+    if(threadCount > chunkCount) threadCount = chunkCount > 0 ? chunkCount : 1;
+
+    char **buffer = calloc(threadCount, sizeof(char *));
+    size_t *length = malloc(threadCount * sizeof(size_t));
+    int allocated = buffer && length;
+    for(int t=0;t<threadCount && allocated;t++) {
+        buffer[t] = malloc((size_t)OUTPUT_CHUNK_PERSONS * MAX_LINE_LENGTH);
+        if(!buffer[t]) allocated = 0;
+    }
+    if(!allocated) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Eroare la alocare buffere de iesire");
+        for(int t=0;buffer && t<threadCount;t++) {
+            free(buffer[t]);
+        }
+        free(buffer);
+        free(length);
+        return -1;
+    }
+
+    int writeError = 0;
+
+    #pragma omp parallel num_threads(threadCount)
+    {
+        int threadID = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+
+        for(int round=0;round*threads<chunkCount;round++) {
+            int chunk = round * threads + threadID;
+            int first = chunk * OUTPUT_CHUNK_PERSONS;
+            int last = first + OUTPUT_CHUNK_PERSONS < simulation->numberOfPersons ? first + OUTPUT_CHUNK_PERSONS : simulation->numberOfPersons;
+
+            char *cursor = buffer[threadID];
+            for(int i=first;i<last;i++) {
+                cursor = formatPerson(cursor, population, i, format);
+            }
+            length[threadID] = chunk < chunkCount ? (size_t)(cursor - buffer[threadID]) : 0;
+            #pragma omp barrier
+
+            // bucatile trebuie scrise in ordinea persoanelor
+            #pragma omp single
+            {
+                for(int t=0;t<threads && writeError == 0;t++) {
+                    if(tryWriteAll(fd, buffer[t], length[t]) != 0) writeError = errno;
+                }
+            }
+        }
+    }
+
+    for(int t=0;t<threadCount;t++) {
+        free(buffer[t]);
+    }
+    free(buffer);
+    free(length);
+
+    if(writeError != 0) {
+        snprintf(error, LOAD_ERROR_LENGTH, "File could not be written: %s", strerror(writeError));
+        return -1;
+    }
+    return 0;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Format Person
+ * Purpose:   Write the row of the person at index in format at cursor (at most MAX_LINE_LENGTH characters)
+ * In args:   cursor, population, index, format
+ * Return:    the position after the row
+ */
+char *formatPerson(char *cursor, Population *population, int index, int format) {
+    if(format == STANDARD_PRINT_FORMAT) {
+        memcpy(cursor, "id:", 3); cursor = formatInt(cursor + 3, population->personID[index]);
+        memcpy(cursor, " x:", 3); cursor = formatInt(cursor + 3, population->x[index]);
+        memcpy(cursor, " y:", 3); cursor = formatInt(cursor + 3, population->y[index]);
+        memcpy(cursor, " st:", 4); cursor = formatInt(cursor + 4, population->status[index]);
+        memcpy(cursor, " mD:", 4); cursor = formatInt(cursor + 4, population->movementDirection[index]);
+        memcpy(cursor, " mA:", 4); cursor = formatInt(cursor + 4, population->movementAmplitude[index]);
+        memcpy(cursor, " iC:", 4); cursor = formatInt(cursor + 4, population->infectionCounter[index]);
+        memcpy(cursor, " sD:", 4); cursor = formatInt(cursor + 4, population->statusDuration[index]);
+    } else {
+        cursor = formatInt(cursor, population->personID[index]); *cursor++ = ' ';
+        cursor = formatInt(cursor, population->x[index]); *cursor++ = ' ';
+        cursor = formatInt(cursor, population->y[index]); *cursor++ = ' ';
+        cursor = formatInt(cursor, population->status[index]); *cursor++ = ' ';
+        cursor = formatInt(cursor, population->movementDirection[index]); *cursor++ = ' ';
+        cursor = formatInt(cursor, population->movementAmplitude[index]);
+        if(format == ONLY_NUMBERS_PRINT_FORMAT) {
+            *cursor++ = ' ';
+            cursor = formatInt(cursor, population->infectionCounter[index]); *cursor++ = ' ';
+            cursor = formatInt(cursor, population->statusDuration[index]);
+        }
+    }
+    *cursor++ = '\n';
+
+    return cursor;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Format Int
+ * Purpose:   Write value in decimal at cursor, like "%d", two digits at a time
+ * In args:   cursor, value
+ * Return:    the position after the last digit
+ */
+char *formatInt(char *cursor, int value) {
+    static const char digitPairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    unsigned int number = value;
+    if(value < 0) {
+        *cursor++ = '-';
+        number = 0u - number;
+    }
+
+    char digits[10];
+    int count = 0;
+    while(number >= 100) {
+        unsigned int pair = (number % 100) * 2;
+        number /= 100;
+        digits[count++] = digitPairs[pair + 1];
+        digits[count++] = digitPairs[pair];
+    }
+    if(number >= 10) {
+        digits[count++] = digitPairs[number * 2 + 1];
+        digits[count++] = digitPairs[number * 2];
+    } else {
+        digits[count++] = '0' + number;
+    }
+
+    while(count > 0) {
+        *cursor++ = digits[--count];
+    }
+    return cursor;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Person Print To Console
+ * Purpose:   Output data for all persons to console
+ * In args:   path, population
+ */
+void personPrintToConsole(Population *population, SimulationData *simulation) {
+    for(int i=0;i<simulation->numberOfPersons;i++) {
+        printf("id:%d ", population->personID[i]);
+        printf("x:%d y:%d ", population->x[i], population->y[i]);
+        printf("st:%d ", population->status[i]);
+        printf("mD:%d ", population->movementDirection[i]);
+        printf("mA:%d ", population->movementAmplitude[i]);
+        printf("iC:%d ", population->infectionCounter[i]);
+        printf("sD:%d\n", population->statusDuration[i]);
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Is Snapshot
+ * Purpose:   Check if the mapped input file is a binary snapshot (starts with SNAPSHOT_MAGIC)
+ * In args:   input
+ */
+int isSnapshot(InputFile *input) {
+    return input->size >= sizeof(SnapshotHeader) && memcmp(input->data, SNAPSHOT_MAGIC, sizeof(((SnapshotHeader *)0)->magic)) == 0;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Snapshot Layout
+ * Purpose:   Compute where every array of a population of numberOfPersons persons starts in a snapshot
+ * In args:   numberOfPersons
+ * Out args:  offsets
+ * Return:    the size of the snapshot file
+ */
+size_t snapshotLayout(int numberOfPersons, size_t offsets[POPULATION_ARRAY_COUNT]) {
+    size_t offset = sizeof(SnapshotHeader);
+    for(int k=0;k<POPULATION_ARRAY_COUNT;k++) {
+        offset = (offset + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+        offsets[k] = offset;
+        offset += (size_t)numberOfPersons * populationElementSize[k];
+    }
+
+    return offset;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Load Snapshot
+ * Purpose:   Use a mapped binary snapshot as a population: the arrays of the population point directly in the mapping,
+            which the population takes over from input (it is unmapped by freePopulation)
+ * In args:   input
+ * Out args:  simulation
+ */
+Population *loadSnapshot(InputFile *input, SimulationData *simulation) {
+    char error[LOAD_ERROR_LENGTH];
+    Population *population = tryLoadSnapshot(input, simulation, error);
+    if(!population) {
+        printf("%s\n", error);
+        exit(-1);
+    }
+
+    return population;
+}
+
+// loadSnapshot care intoarce NULL si motivul in error in loc sa opreasca programul; input ramane al apelantului
+// daca antetul e gresit, altfel maparea e eliberata odata cu populatia
+Population *tryLoadSnapshot(InputFile *input, SimulationData *simulation, char *error) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    snprintf(error, LOAD_ERROR_LENGTH, "Snapshot-urile sunt little-endian, platformele big-endian nu sunt suportate");
+    return NULL;
+#endif
+    SnapshotHeader header;
+    memcpy(&header, input->data, sizeof(header));
+
+    if(header.version != SNAPSHOT_VERSION || header.headerSize != sizeof(SnapshotHeader)) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Versiune de snapshot necunoscuta: %u (se asteapta %d)", header.version, SNAPSHOT_VERSION);
+        return NULL;
+    }
+    if(header.coordSize != sizeof(coord_t)) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Snapshot-ul are coordonate pe %u octeti, programul foloseste %zu (WIDE_COORDINATES)", header.coordSize, sizeof(coord_t));
+        return NULL;
+    }
+    if(header.maxXCoord <= 0 || header.maxYCoord <= 0 || header.maxXCoord > MAX_GRID_SIZE || header.maxYCoord > MAX_GRID_SIZE ||
+       header.numberOfPersons < 0 || header.step < 0) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Antet de snapshot invalid");
+        return NULL;
+    }
+
+    size_t offsets[POPULATION_ARRAY_COUNT];
+    if(snapshotLayout(header.numberOfPersons, offsets) > input->size) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Snapshot-ul este trunchiat");
+        return NULL;
+    }
+
+    simulation->maxXCoord = header.maxXCoord;
+    simulation->maxYCoord = header.maxYCoord;
+    simulation->numberOfPersons = header.numberOfPersons;
+    simulation->startStep = header.step;
+    simulation->infectedDuration = INFECTED_DURATION;
+    simulation->immuneDuration = IMMUNE_DURATION;
+
+    Population *population = malloc(sizeof(Population));
+    if(!population) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Eroare la alocare populatie");
+        return NULL;
+    }
+    void **arrays[POPULATION_ARRAY_COUNT];
+    populationArrays(population, arrays);
+    for(int k=0;k<POPULATION_ARRAY_COUNT;k++) {
+        *arrays[k] = (char *)input->data + offsets[k];
+    }
+    population->mapping = (void *)input->data;
+    population->mappingSize = input->size;
+    input->data = NULL;
+    input->size = 0;
+
+    int invalid = checkPopulation(population, simulation);
+    if(invalid >= 0) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Snapshot invalid: persoana cu indexul %d (id %d) nu are o stare valida", invalid, population->personID[invalid]);
+        freePopulation(population);
+        return NULL;
+    }
+
+    return population;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Save Snapshot
+ * Purpose:   Write the full state of a population (including nextStatus, statusDuration and infectionCounter) and the step
+            in a binary snapshot at path, with the layout of snapshotLayout
+ * In args:   path, population, simulation, step
+ */
+void saveSnapshot(const char *path, Population *population, SimulationData *simulation, int step) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    printf("Snapshot-urile sunt little-endian, platformele big-endian nu sunt suportate\n");
+    exit(-1);
+#endif
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) {
+        printf("File not found!\n");
+        exit(-1);
+    }
+
+    writeSnapshot(fd, population, simulation, step);
+
+    if(close(fd) != 0) {
+        perror("File could not be closed\n");
+        exit(-1);
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Write Snapshot
+ * Purpose:   Write the snapshot of saveSnapshot at the current position of fd
+ * In args:   fd, population, simulation, step
+ */
+void writeSnapshot(int fd, Population *population, SimulationData *simulation, int step) {
+    char error[LOAD_ERROR_LENGTH];
+    if(tryWriteSnapshot(fd, population, simulation, step, error) != 0) {
+        printf("%s\n", error);
+        exit(-1);
+    }
+}
+
+// writeSnapshot care intoarce -1 si eroarea daca o scriere esueaza, in loc sa opreasca programul
+int tryWriteSnapshot(int fd, Population *population, SimulationData *simulation, int step, char *error) {
+    SnapshotHeader header;
+    initSnapshotHeader(&header, simulation, step);
+
+    size_t offsets[POPULATION_ARRAY_COUNT];
+    snapshotLayout(simulation->numberOfPersons, offsets);
+    void **arrays[POPULATION_ARRAY_COUNT];
+    populationArrays(population, arrays);
+
+    static const char padding[SNAPSHOT_ALIGNMENT] = {0};
+    size_t written = sizeof(header);
+    int failed = tryWriteAll(fd, &header, sizeof(header));
+    for(int k=0;k<POPULATION_ARRAY_COUNT && !failed;k++) {
+        failed = tryWriteAll(fd, padding, offsets[k] - written) != 0 ||
+                 tryWriteAll(fd, *arrays[k], (size_t)simulation->numberOfPersons * populationElementSize[k]) != 0;
+        written = offsets[k] + (size_t)simulation->numberOfPersons * populationElementSize[k];
+    }
+    if(failed) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Snapshot-ul nu a putut fi scris: %s", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Memory Snapshot
+ * Purpose:   Write the snapshot of a population in an anonymous file in memory, which mapInputFile and loadSnapshot
+            can map any number of times as private copies of the population
+ * In args:   population, simulation
+ * Return:    the fd of the file in memory
+ */
+int memorySnapshot(Population *population, SimulationData *simulation) {
+    int fd = memfd_create("epidemics_snapshot", 0);
+    if(fd < 0) {
+        perror("Memory file could not be created\n");
+        exit(-1);
+    }
+
+    writeSnapshot(fd, population, simulation, simulation->startStep);
+    return fd;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Init Snapshot Header
+ * Purpose:   Fill the header of a snapshot of the simulation at step
+ * In args:   simulation, step
+ * Out args:  header
+ */
+void initSnapshotHeader(SnapshotHeader *header, SimulationData *simulation, int step) {
+    memset(header, 0, sizeof(SnapshotHeader));
+    memcpy(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic));
+    header->version = SNAPSHOT_VERSION;
+    header->headerSize = sizeof(SnapshotHeader);
+    header->maxXCoord = simulation->maxXCoord;
+    header->maxYCoord = simulation->maxYCoord;
+    header->numberOfPersons = simulation->numberOfPersons;
+    header->step = step;
+    header->coordSize = sizeof(coord_t);
+}
+
+void writeAll(int fd, const void *buffer, size_t size) {
+    if(tryWriteAll(fd, buffer, size) != 0) {
+        perror("File could not be written\n");
+        exit(-1);
+    }
+}
+
+// writeAll care intoarce -1 (cu errno) daca o scriere esueaza, in loc sa opreasca programul; un semnal nu opreste scrierea
+int tryWriteAll(int fd, const void *buffer, size_t size) {
+    const char *data = buffer;
+    while(size > 0) {
+        ssize_t count = write(fd, data, size);
+        if(count < 0) {
+            if(errno == EINTR) continue;
+            return -1;
+        }
+        data += count;
+        size -= count;
+    }
+    return 0;
+}
+
+int getIndexForChar(const char *string, char c) {
+    int stringLength = strlen(string);
+
+    for(int i=0;i<stringLength;i++) {
+        if(string[i] == c) return i;
+    }
+
+    return -1;
+}
+
+char *buildOutputPath(const char *inputPath, char *suffix) {
+    int inputPathLength = strlen(inputPath);
+    int suffixLength = strlen(suffix);
+
+    char *ret = malloc((inputPathLength + suffixLength + 1) * sizeof(char));
+    if(!ret) {
+        printf("Eroare la alocare string de output\n");
+        exit(-1);
+    }
+
+    int inputPathCutoff = getIndexForChar(inputPath, '.'); // vreau sa copiez fara .txt deci iau indexul punctului ca sa copiez doar pana acolo
+    if(inputPathCutoff == -1) {
+        printf("Fisierul nu are nume corespunzator - trebuie sa aiba o extensie cu '.'\n");
+        exit(-1);
+    }
+
+    strncpy(ret, inputPath, inputPathCutoff);
+    ret[inputPathCutoff] = '\0';
+    strcat(ret, suffix);
+
+    return ret;
+}
@@ -1,568 +1,825 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <time.h>
-
-#define INFECTED_DURATION 4
-#define IMMUNE_DURATION 2
+#include "epidemics.h"
 
 #define TOTAL_ARGUMENT_COUNT 4
-
-#define SERIAL_PATH_SUFFIX "_serial_out.txt"
-#define PARALLEL_PATH_SUFFIX "_parallel_out.txt"
-
-// #define DEBUG
-// #define DEBUG_GRID
+#define KERNELS_OPTION "--kernels="
+#define CHECK_KERNELS_OPTION "--check-kernels"
+#define FUSED_OPTION "--fused"
+#define ACTIVE_OPTION "--active"
+#define BINARY_OUTPUT_OPTION "--binary-output"
+#define CONVERT_OPTION "--convert"
+#define CHECKPOINT_OPTION "--checkpoint-every"
+#define RESUME_OPTION "--resume"
+#define STATISTICS_OPTION "--stats="
+#define GRID_OPTION "--grid="
+#define VERIFY_OPTION "--verify"
+#define PTHREADS_OPTION "--pthreads"
+#define BARRIER_OPTION "--barrier="
+#define REORDER_OPTION "--reorder"
+#define CURVE_OPTION "--curve="
+#define FAST_FORWARD_OPTION "--fast-forward"
+#define INFECTED_DURATION_OPTION "--infected-duration="
+#define IMMUNE_DURATION_OPTION "--immune-duration="
+#define BATCH_OPTION "--batch"
+#define GROUPS_OPTION "--groups="
+#define BATCH_PATH_SUFFIX "_batch_out.txt"
+#define BATCH_BINARY_PATH_FORMAT "_batch_%d_out.bin"
+#define ENSEMBLE_OPTION "--ensemble"
+#define SERVE_OPTION "--serve"
+#define SCENARIOS_OPTION "--scenarios="
+#define SEED_OPTION "--seed="
+#define INITIAL_OPTION "--initial="
+#define ENSEMBLE_PATH_FORMAT "_ensemble_%d_out.txt"
+#define ENSEMBLE_BINARY_PATH_FORMAT "_ensemble_%d_out.bin"
+
+#define SERIAL_TRACE_SUFFIX "_serial_trace.json"
+#define PARALLEL_TRACE_SUFFIX "_parallel_trace.json"
 
 typedef struct {
-    int maxXCoord;
-    int maxYCoord;
-    int numberOfPersons;
-    int simulationTime;
-}SimulationData;
-
-typedef struct {
-    int x;
-    int y;
-}Coordinate;
-
+    int kernelType;
+    int checkKernels;
+    int fused;
+    int active;
+    int pthreads;
+    int barrierType;
+    int binaryOutput;
+    int checkpointEvery;    // 0 = fara checkpoint-uri
+    int resume;
+    int statisticsFormat;
+    int gridType;
+    int verifyEvery;        // 0 = fara verificare; altfel din cati in cati pasi sunt comparate versiunile
+    int infectedDuration;
+    int immuneDuration;
+    int reorderEvery;       // -1 = fara reordonare, 0 = adaptiv
+    int curve;
+    int fastForward;
+}ProgramOptions;
+
+// un scenariu al modului batch: populatia lui e o copie privata (copy on write) a populatiei incarcate o data
 typedef struct {
-    int personID;
-    Coordinate coord;
-    int status;
-    int nextStatus;
-    int statusDuration;
-    int movementDirection;
-    int movementAmplitude;
-    int infectionCounter;
-}Person;
-
-typedef struct personNode{
-    int personIndex;
-    struct personNode *next;
-}PersonNode;
-
-typedef enum {
-    INFECTED,
-    SUSCEPTIBLE,
-    IMMUNE
-}Status;
-
-typedef enum {
-    NORTH,  //00
-    SOUTH,  //01
-    EAST,   //10
-    WEST    //11 ^ 0x0001 = 10
-}Directions;
-
-typedef enum {
-    STANDARD_PRINT_FORMAT,
-    ONLY_NUMBERS_PRINT_FORMAT
-}PrintFormats;
+    SimulationData simulation;
+    Population *population;
+    double time;
+}BatchScenario;
 
 void Usage();
-void simulationScan(FILE *file, SimulationData *simulation);
-void personScan(FILE *file, Person *person, SimulationData *simulation);
-void personPrintToFile(FILE *file, Person *person, SimulationData *simulation, int format);
-void personPrintToConsole(Person *person, SimulationData *simulation);
-void updateLocation(Person *person, SimulationData *simulation);
-// void computeNextStatus(Person *person, int index, SimulationData *simulation); // first version
-void computeNextStatus(PersonNode ***grid, Person *person, SimulationData *simulation);
-void updateStatus(Person *person);
-void simulateSerial(PersonNode ***grid, Person *person, SimulationData *simulation);
-
-void initGrid(PersonNode ***grid, Person *person, SimulationData *simulation);
-void printPersonNode(PersonNode *node);
-void appendPersonNode(int personIndex, PersonNode **gridCell);
-void updateGrid(PersonNode ***grid, Person *person, SimulationData *simulation);
-
-void printGrid(PersonNode ***grid, Person *person, SimulationData *simulation);
-void printList(PersonNode* node, Person *person);
-
-void freeGrid(PersonNode ***grid, SimulationData *simulation);
-void freeList(PersonNode *node);
-
-char *buildOutputPath(char *inputPath, char *suffix);
+void parseOptions(int argc, const char *argv[], ProgramOptions *options);
+void printFastForward(FastForward *forward);
+int convertMain(int argc, const char *argv[]);
+int batchMain(int argc, const char *argv[]);
+BatchScenario *readScenarios(const char *path, int *scenarioCount);
+int ensembleMain(int argc, const char *argv[]);
+int serveMain(int argc, const char *argv[]);
 
 int main(int argc, const char *argv[]) {
-    if(argc != TOTAL_ARGUMENT_COUNT) {
+    if(argc > 1 && strcmp(argv[1], CONVERT_OPTION) == 0) {
+        return convertMain(argc, argv);
+    }
+    if(argc > 1 && strcmp(argv[1], BATCH_OPTION) == 0) {
+        return batchMain(argc, argv);
+    }
+    if(argc > 1 && strcmp(argv[1], ENSEMBLE_OPTION) == 0) {
+        return ensembleMain(argc, argv);
+    }
+    if(argc > 1 && strcmp(argv[1], SERVE_OPTION) == 0) {
+        return serveMain(argc, argv);
+    }
+    if(argc < TOTAL_ARGUMENT_COUNT) {
         Usage();
     }
+
+    ProgramOptions options;
+    parseOptions(argc, argv, &options);
+    kernels = getKernels(options.kernelType);
+    barrierType = options.barrierType;
+    SimulationEngine parallelEngine = options.pthreads ? simulatePthreads : options.active ? simulateParallelActive :
+                                      options.fused ? simulateParallelFused : simulateParallel;
+    const char *parallelName = options.pthreads ? "pthreads" : options.active ? "parallel active" : options.fused ? "parallel fused" : "parallel";
     
-    char *path = argv[2];
+    const char *path = argv[2];
     // char *serialOutputPath = "file_serial_out.txt";
-    char *serialOutputPath = buildOutputPath(path, SERIAL_PATH_SUFFIX);
+    char *serialOutputPath = buildOutputPath(path, options.binaryOutput ? SERIAL_BINARY_PATH_SUFFIX : SERIAL_PATH_SUFFIX);
+    char *parallelOutputPath = buildOutputPath(path, options.binaryOutput ? PARALLEL_BINARY_PATH_SUFFIX : PARALLEL_PATH_SUFFIX);
+    int outputFormat = options.binaryOutput ? BINARY_SNAPSHOT_FORMAT : STANDARD_PRINT_FORMAT;
 
-    FILE *inputFile = fopen(path, "r");
-    if(!inputFile) {
-        printf("File not found!\n");
-        exit(-1);
+    int threadNumber = atoi(argv[3]);
+    if(threadNumber <= 0) {
+        printf("Numarul de thread-uri trebuie sa fie pozitiv\n");
+        Usage();
     }
+    omp_set_num_threads(threadNumber);
 
     // init simulation and read person data
     SimulationData simulation;
+    Population *population = loadPopulation(path, &simulation, threadNumber);
+    setDurations(population, &simulation, options.infectedDuration, options.immuneDuration);
     simulation.simulationTime = atoi(argv[1]);
-    simulationScan(inputFile, &simulation);
-
-    PersonNode ***grid = malloc(simulation.maxXCoord * sizeof(PersonNode **));
-    if(!grid) {
-        printf("Eroare la alocare randuri grid\n");
+    if(simulation.simulationTime < simulation.startStep) {
+        printf("Snapshot-ul este la pasul %d, dupa simulationTime %d\n", simulation.startStep, simulation.simulationTime);
         exit(-1);
     }
-    for(int i=0;i<simulation.maxXCoord;i++) {
-        grid[i] = malloc(simulation.maxYCoord * sizeof(PersonNode *));
-        if(!grid[i]) {
-            printf("Eroare la alocare coloana %d din grid\n", i);
-            exit(-1);
-        }
+
+    CellIndex *grid = allocGrid(&simulation, 1, options.gridType);
+    CellIndex *gridParallel = allocGrid(&simulation, threadNumber, options.gridType);
+
+    if(options.checkKernels) {
+        int mismatches = checkKernels(population, &simulation);
+        freePopulation(population);
+        freeGrid(grid);
+        freeGrid(gridParallel);
+        free(serialOutputPath);
+        free(parallelOutputPath);
+        return mismatches == 0 ? 0 : 1;
     }
-    
-    // allocate memory for Person array
-    Person *person = malloc(simulation.numberOfPersons * sizeof(Person));
-    if(!person) {
-        printf("Eroare la alocare array Person\n");
-        exit(-1);
+
+    if(options.verifyEvery > 0) {
+        printf("Verifying %s (%d threads, %s kernels) against serial...\n", parallelName, threadNumber, kernels.name);
+        int failedStep = verifyEngines(parallelEngine, grid, gridParallel, population, &simulation, options.verifyEvery);
+        freePopulation(population);
+        freeGrid(grid);
+        freeGrid(gridParallel);
+        free(serialOutputPath);
+        free(parallelOutputPath);
+        return failedStep < 0 ? 0 : 1;
     }
 
-    personScan(inputFile, person, &simulation);
+    // versiunea paralela porneste de la aceeasi stare initiala ca cea seriala
+    Population *populationParallel = allocPopulation(simulation.numberOfPersons);
+    copyPopulation(populationParallel, population, simulation.numberOfPersons);
+
+    // fiecare versiune are pasul ei de start, daca e reluata din checkpoint-ul ei
+    SimulationData simulationSerial = simulation;
+    SimulationData simulationParallel = simulation;
+    if(options.resume) {
+        resumeFromCheckpoint(path, SERIAL_CHECKPOINT_SUFFIX, &population, &simulationSerial, "Serial");
+        resumeFromCheckpoint(path, PARALLEL_CHECKPOINT_SUFFIX, &populationParallel, &simulationParallel, "Parallel");
+        // snapshot-urile nu retin duratele
+        setDurations(population, &simulationSerial, options.infectedDuration, options.immuneDuration);
+        setDurations(populationParallel, &simulationParallel, options.infectedDuration, options.immuneDuration);
+    }
 
-    if(fclose(inputFile) != 0) {
-        perror("File could not be closed\n");
-        exit(-1);
+    Checkpointer *checkpointerSerial = NULL, *checkpointerParallel = NULL;
+    if(options.checkpointEvery > 0) {
+        checkpointerSerial = createCheckpointer(path, SERIAL_CHECKPOINT_SUFFIX, options.checkpointEvery, &simulation);
+        checkpointerParallel = createCheckpointer(path, PARALLEL_CHECKPOINT_SUFFIX, options.checkpointEvery, &simulation);
+    }
+
+    PersonOrder *orderSerial = NULL, *orderParallel = NULL;
+    if(options.reorderEvery >= 0) {
+        orderSerial = allocPersonOrder(simulation.numberOfPersons, options.reorderEvery, options.curve);
+        orderParallel = allocPersonOrder(simulation.numberOfPersons, options.reorderEvery, options.curve);
+    }
+
+    StatisticsStream *statisticsSerial = NULL, *statisticsParallel = NULL;
+    if(options.statisticsFormat != STATISTICS_NONE) {
+        int binary = options.statisticsFormat == STATISTICS_BINARY;
+        char *serialStatisticsPath = buildOutputPath(path, binary ? SERIAL_BINARY_STATISTICS_SUFFIX : SERIAL_STATISTICS_SUFFIX);
+        char *parallelStatisticsPath = buildOutputPath(path, binary ? PARALLEL_BINARY_STATISTICS_SUFFIX : PARALLEL_STATISTICS_SUFFIX);
+        statisticsSerial = openStatistics(serialStatisticsPath, options.statisticsFormat, &simulation);
+        statisticsParallel = openStatistics(parallelStatisticsPath, options.statisticsFormat, &simulation);
+        free(serialStatisticsPath);
+        free(parallelStatisticsPath);
     }
 
-    initGrid(grid, person, &simulation);
+    initGrid(grid, population, &simulation);
+    initGrid(gridParallel, populationParallel, &simulation);
     // printGrid(grid, &simulation);
 
     struct timespec start, finish;
-    double time = 0;
+    double serialTime = 0, parallelTime = 0;
     
+#ifdef PROFILE_PHASES
+    profileBegin("serial", 1);
+#endif
     printf("Measuring Serial...\n");
     clock_gettime(CLOCK_MONOTONIC, &start);
 
-    simulateSerial(grid, person, &simulation);
+    FastForward forward;
+    if(options.fastForward) {
+        fastForward(simulateSerial, grid, population, &simulationSerial, &forward);
+    } else {
+        runEngine(simulateSerial, grid, population, &simulationSerial, checkpointerSerial, orderSerial, statisticsSerial);
+    }
 
     clock_gettime(CLOCK_MONOTONIC, &finish);
-    time = (finish.tv_sec - start.tv_sec);
-    time += (finish.tv_nsec - start.tv_nsec) / 1000000000.0;
-    printf("Time: %lf\n", time);
+    serialTime = elapsedSeconds(&start, &finish);
+    printf("Time: %lf\n", serialTime);
+    if(orderSerial) printf("Reordered %d times\n", orderSerial->reorderCount);
+    if(options.fastForward) printFastForward(&forward);
+
+#ifdef PROFILE_PHASES
+    char *serialTracePath = buildOutputPath(path, SERIAL_TRACE_SUFFIX);
+    profileEnd(serialTracePath);
+    free(serialTracePath);
+#endif
+
+    writeOutput(serialOutputPath, population, &simulationSerial, outputFormat);
+
+#ifdef PROFILE_PHASES
+    profileBegin(parallelName, threadNumber);
+#endif
+    printf("Measuring Parallel (%d threads, %s kernels%s)...\n", threadNumber, kernels.name,
+           options.pthreads ? (options.barrierType == BARRIER_SPIN ? ", pthreads, spin barrier" : ", pthreads, pthread_barrier_t") :
+           options.active ? ", active set" : options.fused ? ", fused" : "");
+    clock_gettime(CLOCK_MONOTONIC, &start);
 
-    FILE *outputFile = fopen(serialOutputPath, "w");
-    if(!outputFile) {
-        printf("File not found!\n");
-        exit(-1);
+    if(options.fastForward) {
+        fastForward(parallelEngine, gridParallel, populationParallel, &simulationParallel, &forward);
+    } else {
+        runEngine(parallelEngine, gridParallel, populationParallel, &simulationParallel, checkpointerParallel, orderParallel, statisticsParallel);
     }
 
-    personPrintToFile(outputFile, person, &simulation, STANDARD_PRINT_FORMAT);
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+    parallelTime = elapsedSeconds(&start, &finish);
+    printf("Time: %lf\n", parallelTime);
+    if(orderParallel) printf("Reordered %d times\n", orderParallel->reorderCount);
+    if(options.fastForward) printFastForward(&forward);
 
-    if(fclose(outputFile) != 0) {
-        perror("File could not be closed\n");
-        exit(-1);
+#ifdef PROFILE_PHASES
+    char *parallelTracePath = buildOutputPath(path, PARALLEL_TRACE_SUFFIX);
+    profileEnd(parallelTracePath);
+    free(parallelTracePath);
+#endif
+
+    writeOutput(parallelOutputPath, populationParallel, &simulationParallel, outputFormat);
+
+    if(parallelTime > 0) {
+        printf("Speedup: %lf\n", serialTime / parallelTime);
     }
 
-    free(person);
-    freeGrid(grid, &simulation);
+    freePopulation(population);
+    freePopulation(populationParallel);
+    freeGrid(grid);
+    freeGrid(gridParallel);
+    if(checkpointerSerial) freeCheckpointer(checkpointerSerial);
+    if(checkpointerParallel) freeCheckpointer(checkpointerParallel);
+    if(orderSerial) freePersonOrder(orderSerial);
+    if(orderParallel) freePersonOrder(orderParallel);
+    if(statisticsSerial) closeStatistics(statisticsSerial);
+    if(statisticsParallel) closeStatistics(statisticsParallel);
+    free(serialOutputPath);
+    free(parallelOutputPath);
 
     return 0;
 }
 
 /*-----------------------------------------------------------------
- * Function:  Simulate Serial
- * Purpose:   Simulates the serial version of the algorithm
- * In args:   person, simulation
+ * Function:  Convert Main
+ * Purpose:   ./program_name --convert source destination [format]: read source (text input or binary snapshot) and write it to destination,
+            as a binary snapshot if destination ends in .bin, otherwise as text in the input format (default), standard or numbers format;
+            text output files have no grid size, so only text input files and snapshots can be converted from
+ * In args:   argc, argv
  */
-void simulateSerial(PersonNode ***grid, Person *person, SimulationData *simulation) {
-    // each time step
-    for(int time=0;time<simulation->simulationTime;time++) {
-        #ifdef DEBUG
-            personPrintToConsole(person, simulation);
-            printf("\n");
-        #endif
-
-        updateGrid(grid, person, simulation);
-    #ifdef DEBUG_GRID
-        printGrid(grid, person, simulation);
-        printf("\n");
-    #endif
-
-        // version 1 compute status
-        // for(int i=0;i<simulation->numberOfPersons;i++) {
-        //     computeNextStatus(person, i, simulation);
-        // }
-
-        computeNextStatus(grid, person, simulation);
-
-        for(int i=0;i<simulation->numberOfPersons;i++) {
-            updateStatus(&(person[i]));
-        }
+int convertMain(int argc, const char *argv[]) {
+    if(argc < 4 || argc > 5) {
+        Usage();
+    }
 
-        // update locations
-        for(int i=0;i<simulation->numberOfPersons;i++) {
-            updateLocation(&(person[i]), simulation);
+    int format = INPUT_PRINT_FORMAT;
+    size_t destinationLength = strlen(argv[3]);
+    if(destinationLength >= strlen(BINARY_EXTENSION) && strcmp(argv[3] + destinationLength - strlen(BINARY_EXTENSION), BINARY_EXTENSION) == 0) {
+        format = BINARY_SNAPSHOT_FORMAT;
+    } else if(argc == 5) {
+        if(strcmp(argv[4], "input") == 0) {
+            format = INPUT_PRINT_FORMAT;
+        } else if(strcmp(argv[4], "standard") == 0) {
+            format = STANDARD_PRINT_FORMAT;
+        } else if(strcmp(argv[4], "numbers") == 0) {
+            format = ONLY_NUMBERS_PRINT_FORMAT;
+        } else {
+            Usage();
         }
     }
+
+    SimulationData simulation;
+    Population *population = loadPopulation(argv[2], &simulation, omp_get_max_threads());
+    simulation.simulationTime = simulation.startStep;
+
+    writeOutput(argv[3], population, &simulation, format);
+    printf("%d persons (step %d) written to %s\n", simulation.numberOfPersons, simulation.startStep, argv[3]);
+
+    freePopulation(population);
+    return 0;
 }
 
 /*-----------------------------------------------------------------
- * Function:  Init Grid
- * Purpose:   Go through all the cells of the grid and initialize them with NULL, then put all persons in the cells they belong to at the start based on current x and y coordinates
- * In args:   grid, person, simulation
+ * Function:  Batch Main
+ * Purpose:   ./program_name --batch scenarioFile inputFileName threadNumber [--groups=G] [--binary-output]: load the input once and run
+            every scenario of scenarioFile with the parallel engine, G scenarios at a time, each on its own group of threads (nested
+            parallel regions); the loaded population is kept in a file in memory (or the snapshot input file itself) and every scenario
+            maps it privately, so a scenario only copies the pages of the persons it changes; the results of all scenarios are written
+            after the last one ends
+ * In args:   argc, argv
  */
-void initGrid(PersonNode ***grid, Person *person, SimulationData *simulation) {
-    for(int i=0;i<simulation->maxXCoord;i++) {
-        for(int j=0;j<simulation->maxYCoord;j++) {
-            grid[i][j] = NULL;
+int batchMain(int argc, const char *argv[]) {
+    if(argc < 5) {
+        Usage();
+    }
+
+    const char *path = argv[3];
+    int threadNumber = atoi(argv[4]);
+    if(threadNumber <= 0) {
+        printf("Numarul de thread-uri trebuie sa fie pozitiv\n");
+        Usage();
+    }
+    int groups = 0, binaryOutput = 0;
+    for(int i=5;i<argc;i++) {
+        if(strncmp(argv[i], GROUPS_OPTION, strlen(GROUPS_OPTION)) == 0) {
+            groups = atoi(argv[i] + strlen(GROUPS_OPTION));
+            if(groups <= 0) {
+                Usage();
+            }
+        } else if(strcmp(argv[i], BINARY_OUTPUT_OPTION) == 0) {
+            binaryOutput = 1;
+        } else {
+            Usage();
         }
     }
-}
 
-void appendPersonNode(int personIndex, PersonNode **gridCell) {
-    PersonNode *node = malloc(sizeof(PersonNode));
-    if(!node) {
-        printf("Eroare la alocare dinamica nod pentru persoana cu index %d\n", personIndex);
+    int scenarioCount;
+    BatchScenario *scenarios = readScenarios(argv[2], &scenarioCount);
+    if(groups == 0) groups = scenarioCount;
+    if(groups > threadNumber) groups = threadNumber;
+    int groupThreads = threadNumber / groups;
+    kernels = getKernels(KERNELS_AUTO);
+
+    // populatia e incarcata o singura data; un fisier text e pus intr-un snapshot in memorie
+    SimulationData simulation;
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        printf("File not found!\n");
         exit(-1);
     }
+    InputFile input = mapInputFile(fd);
+    Population *population;
+    if(isSnapshot(&input)) {
+        population = loadSnapshot(&input, &simulation);
+    } else {
+        simulationScan(&input, &simulation);
+        population = allocPopulation(simulation.numberOfPersons);
+        omp_set_num_threads(threadNumber);
+        personScan(&input, population, &simulation, threadNumber);
+        closeInputFile(&input);
+        close(fd);
+        fd = memorySnapshot(population, &simulation);
+    }
+    freePopulation(population);
 
-    node->personIndex = personIndex;
-    node->next = *gridCell;
-    *gridCell = node;
-}
-
-void printGrid(PersonNode ***grid, Person *person, SimulationData *simulation) {
-    for(int i=0;i<simulation->maxXCoord;i++) {
-        for(int j=0;j<simulation->maxYCoord;j++) {
-            // printPersonNode(grid[i][j]);
-            printf("[%d][%d]: ", i, j);
-            printList(grid[i][j], person);
+    for(int k=0;k<scenarioCount;k++) {
+        if(scenarios[k].simulation.simulationTime < simulation.startStep) {
+            printf("Scenariul %d: snapshot-ul este la pasul %d, dupa simulationTime %d\n", k + 1, simulation.startStep,
+                   scenarios[k].simulation.simulationTime);
+            exit(-1);
         }
-        printf("\n");
     }
-}
 
-void printList(PersonNode* node, Person *person) {
-    PersonNode *traverser = node;
-    while(traverser != NULL) {
-        printf("(%d, %d) ", traverser->personIndex + 1, person[traverser->personIndex].status);
-        traverser = traverser->next;
+    printf("Running %d scenarios (%d groups x %d threads, %s kernels)...\n", scenarioCount, groups, groupThreads, kernels.name);
+    double start = omp_get_wtime();
+
+    omp_set_max_active_levels(2);
+    #pragma omp parallel for num_threads(groups) schedule(dynamic, 1)
+    for(int k=0;k<scenarioCount;k++) {
+        BatchScenario *scenario = &scenarios[k];
+        InputFile mapping = mapInputFile(fd);
+        SimulationData scenarioSimulation;
+        scenario->population = loadSnapshot(&mapping, &scenarioSimulation);
+        scenarioSimulation.simulationTime = scenario->simulation.simulationTime;
+        setDurations(scenario->population, &scenarioSimulation, scenario->simulation.infectedDuration, scenario->simulation.immuneDuration);
+        scenario->simulation = scenarioSimulation;
+
+        double scenarioStart = omp_get_wtime();
+        CellIndex *grid = allocGrid(&scenario->simulation, groupThreads, GRID_AUTO);
+        initGrid(grid, scenario->population, &scenario->simulation);
+        simulateParallel(grid, scenario->population, &scenario->simulation, NULL);
+        freeGrid(grid);
+        scenario->time = omp_get_wtime() - scenarioStart;
     }
-    printf("\n");
-}
-
-void freeList(PersonNode *node) {
-    if(node == NULL) return;
 
-    PersonNode *traverser = node;
-    while(traverser != NULL) {
-        node = node->next;
-        free(traverser);
-        traverser = node;
+    double time = omp_get_wtime() - start;
+    close(fd);
+    printf("Time: %lf\n", time);
+    printf("%-10s %-15s %-17s %-15s %s\n", "scenario", "simulationTime", "infectedDuration", "immuneDuration", "time");
+    for(int k=0;k<scenarioCount;k++) {
+        printf("%-10d %-15d %-17d %-15d %lf\n", k + 1, scenarios[k].simulation.simulationTime, scenarios[k].simulation.infectedDuration,
+               scenarios[k].simulation.immuneDuration, scenarios[k].time);
     }
-}
 
-void printPersonNode(PersonNode *node) {
-    if(node == NULL) {
-        printf("NULL ");
+    // rezultatele tuturor scenariilor, scrise dupa ce s-au terminat toate
+    omp_set_num_threads(threadNumber);
+    if(binaryOutput) {
+        char suffix[sizeof(BATCH_BINARY_PATH_FORMAT) + 16];
+        for(int k=0;k<scenarioCount;k++) {
+            snprintf(suffix, sizeof(suffix), BATCH_BINARY_PATH_FORMAT, k + 1);
+            char *outputPath = buildOutputPath(path, suffix);
+            writeOutput(outputPath, scenarios[k].population, &scenarios[k].simulation, BINARY_SNAPSHOT_FORMAT);
+            free(outputPath);
+        }
     } else {
-        printf("%d ", node->personIndex);
+        char *outputPath = buildOutputPath(path, BATCH_PATH_SUFFIX);
+        int outputFile = open(outputPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(outputFile < 0) {
+            printf("File not found!\n");
+            exit(-1);
+        }
+        for(int k=0;k<scenarioCount;k++) {
+            char header[MAX_LINE_LENGTH];
+            int length = snprintf(header, sizeof(header), "scenario %d: simulationTime %d infectedDuration %d immuneDuration %d\n", k + 1,
+                                  scenarios[k].simulation.simulationTime, scenarios[k].simulation.infectedDuration,
+                                  scenarios[k].simulation.immuneDuration);
+            writeAll(outputFile, header, length);
+            personPrintToFile(outputFile, scenarios[k].population, &scenarios[k].simulation, STANDARD_PRINT_FORMAT);
+        }
+        if(close(outputFile) != 0) {
+            perror("File could not be closed\n");
+            exit(-1);
+        }
+        free(outputPath);
+    }
+
+    for(int k=0;k<scenarioCount;k++) {
+        freePopulation(scenarios[k].population);
     }
+    free(scenarios);
+    return 0;
 }
 
 /*-----------------------------------------------------------------
- * Function:  Update Grid
- * Purpose:   Go through all the cells of the grid and update the locations of the persons in each one;
-            update consist of erasing the previous values for all cells, setting them to NULL and repopulating the cells by using x and y
- * In args:   grid, person, simulation
+ * Function:  Read Scenarios
+ * Purpose:   Read the scenarios of the batch mode, one per line: simulationTime and optionally infectedDuration and immuneDuration
+            (INFECTED_DURATION and IMMUNE_DURATION if they are not given); empty lines and lines starting with '#' are skipped
+ * In args:   path
+ * Out args:  scenarioCount
+ * Return:    the scenarios, with only the simulationTime and the durations of their simulation set
  */
-void updateGrid(PersonNode ***grid, Person *person, SimulationData *simulation) {
-    for(int i=0;i<simulation->maxXCoord;i++) {
-        for(int j=0;j<simulation->maxYCoord;j++) {
-            freeList(grid[i][j]);
-            grid[i][j] = NULL;
+BatchScenario *readScenarios(const char *path, int *scenarioCount) {
+    InputFile input = openInputFile(path);
+    const char *end = input.data + input.size;
+    int capacity = 0;
+    BatchScenario *scenarios = NULL;
+    int line = 0;
+    *scenarioCount = 0;
+
+    for(const char *cursor = input.data, *nextLine; cursor && cursor < end; cursor = nextLine) {
+        int values[3];
+        line++;
+        if(*cursor == '#') {
+            const char *newLine = memchr(cursor, '\n', end - cursor);
+            nextLine = newLine ? newLine + 1 : end;
+            continue;
+        }
+        int count = parseLine(cursor, end, values, 3, &nextLine);
+        if(count == 0) continue;
+        if(count < 0 || values[0] < 0) {
+            printf("Scenariu invalid la randul %d din %s\n", line, path);
+            exit(-1);
         }
-    }
-
-    // parcurg array-ul
-    for(int i=0;i<simulation->numberOfPersons;i++) {
-        int x = person[i].coord.x;
-        int y = person[i].coord.y;
-        // printf("%d %d\n", x, y);
 
-        // preiau coordonatele x si y si adaug persoanele intr-o lista simplu inlantuita formata in celula x, y
-        appendPersonNode(i, &grid[x][y]);
+        if(*scenarioCount == capacity) {
+            capacity = capacity ? 2 * capacity : 16;
+            scenarios = realloc(scenarios, capacity * sizeof(BatchScenario));
+            if(!scenarios) {
+                printf("Eroare la alocare scenarii\n");
+                exit(-1);
+            }
+        }
+        BatchScenario *scenario = &scenarios[(*scenarioCount)++];
+        memset(scenario, 0, sizeof(BatchScenario));
+        scenario->simulation.simulationTime = values[0];
+        scenario->simulation.infectedDuration = count > 1 ? values[1] : INFECTED_DURATION;
+        scenario->simulation.immuneDuration = count > 2 ? values[2] : IMMUNE_DURATION;
+        // duratele sunt verificate acum, nu in regiunea paralela
+        setDurations(NULL, &scenario->simulation, scenario->simulation.infectedDuration, scenario->simulation.immuneDuration);
     }
-}
 
-/*-----------------------------------------------------------------
- * Function:  Usage
- * Purpose:   Show and explain usage of the executable program and its command line arguments
- */
-void Usage() {
-    printf("Invalid arguments. Program call should be: ./program_name simulationTime inputFileName threadNumber\n");
-    exit(-1);
+    closeInputFile(&input);
+    if(*scenarioCount == 0) {
+        printf("%s nu are niciun scenariu\n", path);
+        exit(-1);
+    }
+    return scenarios;
 }
 
 /*-----------------------------------------------------------------
- * Function:  Simulation Scan
- * Purpose:   Read the fields of simulation given in the file parameter (maxXCoords, maxYCoords, numberOfPersons)
- * In args:   file, simulation
+ * Function:  Ensemble Main
+ * Purpose:   ./program_name --ensemble simulationTime inputFileName threadNumber [--scenarios=N] [--seed=S] [--initial=P] [durations]
+            [--binary-output]: simulate N scenarios that only differ in who is infected at the start with one movement pass
+            (simulateEnsemble); scenario 0 is the input itself, in the others every person that is not immune is infected with
+            probability P (default the fraction of infected persons of the input); every scenario is written to its own file
+ * In args:   argc, argv
  */
-void simulationScan(FILE *file, SimulationData *simulation) {
-    fscanf(file, "%d %d", &simulation->maxXCoord, &simulation->maxYCoord);
-    fscanf(file, "%d", &simulation->numberOfPersons);
-}
+int ensembleMain(int argc, const char *argv[]) {
+    if(argc < 5) {
+        Usage();
+    }
 
-/*-----------------------------------------------------------------
- * Function:  Person Scan
- * Purpose:   Input data into person array from file with pathname given by path parameter. Also updates the status of the person read in order to initialize both status and nextStatus
- * In args:   path, person
- */
-void personScan(FILE *file, Person *person, SimulationData *simulation) {
-    for(int i=0;i<simulation->numberOfPersons;i++) {
-        fscanf(file, "%d", &(person[i].personID));
-        fscanf(file, "%d %d", &(person[i].coord.x), &(person[i].coord.y));
-        fscanf(file, "%d", &(person[i].nextStatus));
-        fscanf(file, "%d", &(person[i].movementDirection));
-        fscanf(file, "%d", &(person[i].movementAmplitude));
-        person[i].infectionCounter = 0;
-        person[i].statusDuration = 0;
-
-        updateStatus(&(person[i]));
-        if(person[i].status == INFECTED) {
-            person[i].statusDuration++;
+    const char *path = argv[3];
+    int threadNumber = atoi(argv[4]);
+    if(threadNumber <= 0) {
+        printf("Numarul de thread-uri trebuie sa fie pozitiv\n");
+        Usage();
+    }
+    int scenarioCount = ENSEMBLE_MAX_SCENARIOS, binaryOutput = 0;
+    int infectedDuration = INFECTED_DURATION, immuneDuration = IMMUNE_DURATION;
+    uint64_t seed = 1;
+    double initial = -1;
+    for(int i=5;i<argc;i++) {
+        if(strncmp(argv[i], SCENARIOS_OPTION, strlen(SCENARIOS_OPTION)) == 0) {
+            scenarioCount = atoi(argv[i] + strlen(SCENARIOS_OPTION));
+            if(scenarioCount <= 0 || scenarioCount > ENSEMBLE_MAX_SCENARIOS) {
+                printf("Numarul de scenarii trebuie sa fie intre 1 si %d\n", ENSEMBLE_MAX_SCENARIOS);
+                Usage();
+            }
+        } else if(strncmp(argv[i], SEED_OPTION, strlen(SEED_OPTION)) == 0) {
+            seed = strtoull(argv[i] + strlen(SEED_OPTION), NULL, 10);
+        } else if(strncmp(argv[i], INITIAL_OPTION, strlen(INITIAL_OPTION)) == 0) {
+            initial = atof(argv[i] + strlen(INITIAL_OPTION));
+            if(initial < 0 || initial > 1) {
+                printf("Probabilitatea de infectare trebuie sa fie intre 0 si 1\n");
+                Usage();
+            }
+        } else if(strncmp(argv[i], INFECTED_DURATION_OPTION, strlen(INFECTED_DURATION_OPTION)) == 0) {
+            infectedDuration = atoi(argv[i] + strlen(INFECTED_DURATION_OPTION));
+        } else if(strncmp(argv[i], IMMUNE_DURATION_OPTION, strlen(IMMUNE_DURATION_OPTION)) == 0) {
+            immuneDuration = atoi(argv[i] + strlen(IMMUNE_DURATION_OPTION));
+        } else if(strcmp(argv[i], BINARY_OUTPUT_OPTION) == 0) {
+            binaryOutput = 1;
+        } else {
+            Usage();
         }
     }
-}
 
-/*-----------------------------------------------------------------
- * Function:  Person Print To File
- * Purpose:   Output data for all persons into a file
- * In args:   file, path, person
- */
-void personPrintToFile(FILE *file, Person *person, SimulationData *simulation, int format) {
-    if(format == STANDARD_PRINT_FORMAT) {
-        for(int i=0;i<simulation->numberOfPersons;i++) {
-            fprintf(file, "id:%d ", person[i].personID);
-            fprintf(file, "x:%d y:%d ", person[i].coord.x, person[i].coord.y);
-            fprintf(file, "st:%d ", person[i].status);
-            fprintf(file, "mD:%d ", person[i].movementDirection);
-            fprintf(file, "mA:%d ", person[i].movementAmplitude);
-            fprintf(file, "iC:%d ", person[i].infectionCounter);
-            fprintf(file, "sD:%d\n", person[i].statusDuration);
-        }
-    } else if(format == ONLY_NUMBERS_PRINT_FORMAT) {
-        for(int i=0;i<simulation->numberOfPersons;i++) {
-            fprintf(file, "%d ", person[i].personID);
-            fprintf(file, "%d %d ", person[i].coord.x, person[i].coord.y);
-            fprintf(file, "%d ", person[i].status);
-            fprintf(file, "%d ", person[i].movementDirection);
-            fprintf(file, "%d ", person[i].movementAmplitude);
-            fprintf(file, "%d ", person[i].infectionCounter);
-            fprintf(file, "%d\n", person[i].statusDuration);
-        }
+    omp_set_num_threads(threadNumber);
+    kernels = getKernels(KERNELS_AUTO);
+    SimulationData simulation;
+    Population *population = loadPopulation(path, &simulation, threadNumber);
+    setDurations(population, &simulation, infectedDuration, immuneDuration);
+    simulation.simulationTime = atoi(argv[2]);
+    if(simulation.simulationTime < simulation.startStep) {
+        printf("Snapshot-ul este la pasul %d, dupa simulationTime %d\n", simulation.startStep, simulation.simulationTime);
+        exit(-1);
     }
-}
 
-/*-----------------------------------------------------------------
- * Function:  Person Print To Console
- * Purpose:   Output data for all persons to console
- * In args:   path, person
- */
-void personPrintToConsole(Person *person, SimulationData *simulation) {
-    for(int i=0;i<simulation->numberOfPersons;i++) {
-        printf("id:%d ", person[i].personID);
-        printf("x:%d y:%d ", person[i].coord.x, person[i].coord.y);
-        printf("st:%d ", person[i].status);
-        printf("mD:%d ", person[i].movementDirection);
-        printf("mA:%d ", person[i].movementAmplitude);
-        printf("iC:%d ", person[i].infectionCounter);
-        printf("sD:%d\n", person[i].statusDuration);
+    int n = simulation.numberOfPersons;
+    if(initial < 0) {
+        int infected = 0;
+        for(int i=0;i<n;i++) infected += population->status[i] == INFECTED;
+        initial = n > 0 ? (double)infected / n : 0;
+    }
+
+    Ensemble *ensemble = allocEnsemble(population, &simulation, scenarioCount, initial, seed);
+    int initialInfected[ENSEMBLE_MAX_SCENARIOS], infected[ENSEMBLE_MAX_SCENARIOS], immune[ENSEMBLE_MAX_SCENARIOS];
+    long long infections[ENSEMBLE_MAX_SCENARIOS];
+    ensembleCounts(ensemble, n, initialInfected, immune, infections);
+
+    printf("Running %d scenarios (%d threads, initial infection probability %lf, seed %llu)...\n", scenarioCount, threadNumber, initial,
+           (unsigned long long)seed);
+    double start = omp_get_wtime();
+    CellIndex *grid = allocGrid(&simulation, threadNumber, GRID_AUTO);
+    initGrid(grid, population, &simulation);
+    simulateEnsemble(grid, population, ensemble, &simulation);
+    double time = omp_get_wtime() - start;
+    printf("Time: %lf\n", time);
+
+    ensembleCounts(ensemble, n, infected, immune, infections);
+    printf("%-10s %-17s %-10s %-10s %-12s %s\n", "scenario", "initialInfected", "infected", "immune", "susceptible", "infections");
+    for(int s=0;s<scenarioCount;s++) {
+        printf("%-10d %-17d %-10d %-10d %-12d %lld\n", s, initialInfected[s], infected[s], immune[s], n - infected[s] - immune[s], infections[s]);
     }
+
+    // fiecare scenariu e scris din aceeasi populatie, cu starea lui
+    char suffix[sizeof(ENSEMBLE_BINARY_PATH_FORMAT) + 16];
+    for(int s=0;s<scenarioCount;s++) {
+        snprintf(suffix, sizeof(suffix), binaryOutput ? ENSEMBLE_BINARY_PATH_FORMAT : ENSEMBLE_PATH_FORMAT, s);
+        char *outputPath = buildOutputPath(path, suffix);
+        extractScenario(ensemble, s, population, &simulation);
+        writeOutput(outputPath, population, &simulation, binaryOutput ? BINARY_SNAPSHOT_FORMAT : STANDARD_PRINT_FORMAT);
+        free(outputPath);
+    }
+
+    freeGrid(grid);
+    freeEnsemble(ensemble);
+    freePopulation(population);
+    return 0;
 }
 
 /*-----------------------------------------------------------------
- * Function:  Update Location
- * Purpose:   Update the location of a person and take care of out of test area
- * In args:   person
+ * Function:  Serve Main
+ * Purpose:   ./program_name --serve socketPath threadNumber: keep populations in memory and run the jobs of the clients of the
+            Unix domain socket at socketPath (runServer) until one of them sends SHUTDOWN
+ * In args:   argc, argv
  */
-void updateLocation(Person *person, SimulationData *simulation) {
-    switch (person->movementDirection) {
-        case NORTH:
-            person->coord.x += person->movementAmplitude;
-            if (person->coord.x >= simulation->maxXCoord) {
-                person->coord.x = simulation->maxXCoord - 1;
-                person->movementDirection ^= 1;
-            }
-            break;
-        case SOUTH:
-            person->coord.x -= person->movementAmplitude;
-            if (person->coord.x < 0) {
-                person->coord.x = 0;
-                person->movementDirection ^= 1;
-            }
-            break;
-        case EAST:
-            person->coord.y += person->movementAmplitude;
-            if (person->coord.y >= simulation->maxYCoord) {
-                person->coord.y = simulation->maxYCoord - 1;
-                person->movementDirection ^= 1;
-            }
-            break;
-        case WEST:
-            person->coord.y -= person->movementAmplitude;
-            if (person->coord.y < 0) {
-                person->coord.y = 0;
-                person->movementDirection ^= 1;
-            }
-            break;
-        default:
+int serveMain(int argc, const char *argv[]) {
+    if(argc != 4) {
+        Usage();
     }
+
+    int threadNumber = atoi(argv[3]);
+    if(threadNumber <= 0) {
+        printf("Numarul de thread-uri trebuie sa fie pozitiv\n");
+        Usage();
+    }
+    omp_set_num_threads(threadNumber);
+    kernels = getKernels(KERNELS_AUTO);
+    return runServer(argv[2], threadNumber);
 }
 
 /*-----------------------------------------------------------------
- * Function:  Compute NextStatus
- * Purpose:   Compute the next status for a person
- * In args:   grid, person, simulation
+ * Function:  Usage
+ * Purpose:   Show and explain usage of the executable program and its command line arguments
  */
-void computeNextStatus(PersonNode ***grid, Person *person, SimulationData *simulation) {
-    for(int i=0;i<simulation->maxXCoord;i++) {
-        for(int j=0;j<simulation->maxYCoord;j++) {
-            int infectedFound = 0;
-
-            // verifica fiecare nod din lista
-            PersonNode *traverser = grid[i][j];
-            while(traverser != NULL) {
-                int index = traverser->personIndex;
-                switch(person[index].status) {
-                    case INFECTED: // daca este infectat seteaza infectedFound si daca durata a ajuns la 0 seteaza urmatoarea stare pe immune
-                        infectedFound = 1;
-                        if(person[index].statusDuration == 0) {
-                            person[index].nextStatus = IMMUNE;
-                        }
-                        break;
-                    case IMMUNE: // daca durata a ajuns la 0 seteaza pe susceptible la urmatoarea stare
-                        if(person[index].statusDuration == 0) {
-                            person[index].nextStatus = SUSCEPTIBLE;
-                        }
-                        break;
-                    case SUSCEPTIBLE: // nu trebuie facut nimic aici
-                        break;
-                }
-
-                // update reference
-                traverser = traverser->next;
-            }
-            
-            if(infectedFound) { // daca o persoana este infectata vom infecta si celelalte persoane susceptibile din aceeasi celula
-                traverser = grid[i][j];
-                while(traverser != NULL) {
-                    if(person[traverser->personIndex].status == SUSCEPTIBLE)
-                        person[traverser->personIndex].nextStatus = INFECTED;
-
-                    // update reference
-                    traverser = traverser->next;
-                }
-            }
-        }
-    }
+void Usage() {
+    printf("Invalid arguments. Program call should be: ./program_name simulationTime inputFileName threadNumber [options]\n");
+    printf("                                        or: ./program_name %s source destination [input|standard|numbers]\n", CONVERT_OPTION);
+    printf("                                        or: ./program_name %s scenarioFile inputFileName threadNumber [%sG] [%s]\n",
+           BATCH_OPTION, GROUPS_OPTION, BINARY_OUTPUT_OPTION);
+    printf("                                        or: ./program_name %s simulationTime inputFileName threadNumber [%sN] [%sS] [%sP]\n",
+           ENSEMBLE_OPTION, SCENARIOS_OPTION, SEED_OPTION, INITIAL_OPTION);
+    printf("                                            [%sN] [%sN] [%s]\n", INFECTED_DURATION_OPTION, IMMUNE_DURATION_OPTION,
+           BINARY_OUTPUT_OPTION);
+    printf("                                        or: ./program_name %s socketPath threadNumber\n", SERVE_OPTION);
+    printf("inputFileName can be a text input file or a binary snapshot; simulationTime is the step the simulation stops at\n");
+    printf("Options:\n");
+    printf("  %sauto|scalar|avx2|avx512   kernels for the status and location updates of the parallel version (default auto)\n", KERNELS_OPTION);
+    printf("  %s                  compare the vectorized kernels with the scalar ones and exit\n", CHECK_KERNELS_OPTION);
+    printf("  %s                          parallel version updates status, location and the cells of the next step in one pass\n", FUSED_OPTION);
+    printf("  %s                         parallel version only tracks infected / immune persons and the cells of the infected ones\n",
+           ACTIVE_OPTION);
+    printf("  %s                       parallel version on POSIX threads created once per run, with a barrier between the phases\n",
+           PTHREADS_OPTION);
+    printf("  %sspin|pthread          barrier of %s: sense reversing spin barrier (default) or pthread_barrier_t\n", BARRIER_OPTION,
+           PTHREADS_OPTION);
+    printf("  %s                  write the results as binary snapshots (%s, %s)\n", BINARY_OUTPUT_OPTION, SERIAL_BINARY_PATH_SUFFIX, PARALLEL_BINARY_PATH_SUFFIX);
+    printf("  %s N             save the full state every N steps (%s, %s)\n", CHECKPOINT_OPTION, SERIAL_CHECKPOINT_SUFFIX, PARALLEL_CHECKPOINT_SUFFIX);
+    printf("  %s                         continue every version from its checkpoint, if there is one\n", RESUME_OPTION);
+    printf("  %scsv|binary              write the counts of every step (%s, %s or .bin)\n", STATISTICS_OPTION, SERIAL_STATISTICS_SUFFIX, PARALLEL_STATISTICS_SUFFIX);
+    printf("  %s[=K]                    run serial and parallel side by side, compare all persons every K steps (default 1) and exit\n",
+           VERIFY_OPTION);
+    printf("  %sauto|dense|sparse         cell index: one entry per grid cell, or only the occupied cells (default auto, sparse above %d cells per person)\n",
+           GRID_OPTION, SPARSE_CELLS_PER_PERSON);
+    printf("  %s[=K]                   reorder the persons by the cell on a space filling curve every K steps (adaptive without K);\n",
+           REORDER_OPTION);
+    printf("                                 the results are written in the original order\n");
+    printf("  %smorton|hilbert           curve of %s (default morton)\n", CURVE_OPTION, REORDER_OPTION);
+    printf("  %s                  skip the steps that repeat the state of all persons (with the movement in closed form);\n",
+           FAST_FORWARD_OPTION);
+    printf("                                 not with %s, %s or %s\n", STATISTICS_OPTION, CHECKPOINT_OPTION, REORDER_OPTION);
+    printf("  %sN / %sN   steps a person stays infected / immune (default %d / %d; a resumed run needs the same ones)\n",
+           INFECTED_DURATION_OPTION, IMMUNE_DURATION_OPTION, INFECTED_DURATION, IMMUNE_DURATION);
+    printf("Batch: every line of scenarioFile is \"simulationTime [infectedDuration [immuneDuration]]\" ('#' starts a comment line);\n");
+    printf("  the input is loaded once, the scenarios run in G groups of threadNumber / G threads (default one group per scenario, at most\n");
+    printf("  threadNumber) and all results are written at the end, in %s (or %s, one snapshot per scenario)\n",
+           BATCH_PATH_SUFFIX, BATCH_BINARY_PATH_FORMAT);
+    printf("Ensemble: up to %d scenarios (default %d) share the movement, one bit per scenario; scenario 0 starts like the input, in the\n",
+           ENSEMBLE_MAX_SCENARIOS, ENSEMBLE_MAX_SCENARIOS);
+    printf("  others every person that is not immune is infected with probability P (default the infected fraction of the input),\n");
+    printf("  drawn from seed S (default 1); scenario s is written to %s (or %s)\n", ENSEMBLE_PATH_FORMAT, ENSEMBLE_BINARY_PATH_FORMAT);
+    printf("Serve: one command per line on the socket, answered with \"OK ...\" or \"ERROR message\":\n");
+    printf("  LOAD path [infectedDuration immuneDuration] | RUN id steps threads [parallel|fused|active|pthreads] [stats] |\n");
+    printf("  RESULT id [standard|binary] | LIST | UNLOAD id | QUIT | SHUTDOWN (STATS and RESULT send \"kind bytes\" and the bytes first)\n");
+    printf("  RUN uses 1 .. threadNumber threads; a command that fails (input, memory, threads, writes) is answered with ERROR,\n");
+    printf("  the server and its populations keep running\n");
+    exit(-1);
 }
 
 /*-----------------------------------------------------------------
- * Function:  Update Status
- * Purpose:   Update the status to next status of a persons
- * In args:   person
+ * Function:  Parse Options
+ * Purpose:   Read the optional arguments given after threadNumber
+ * In args:   argc, argv
+ * Out args:  options
  */
-void updateStatus(Person *person) {
-    person->status = person->nextStatus;
-    switch (person->status) {
-        case INFECTED:
-            if (person->statusDuration == 0) {
-                person->statusDuration = INFECTED_DURATION - 1;
-                person->infectionCounter++;
+void parseOptions(int argc, const char *argv[], ProgramOptions *options) {
+    options->kernelType = KERNELS_AUTO;
+    options->checkKernels = 0;
+    options->fused = 0;
+    options->active = 0;
+    options->pthreads = 0;
+    options->barrierType = BARRIER_SPIN;
+    options->binaryOutput = 0;
+    options->checkpointEvery = 0;
+    options->resume = 0;
+    options->statisticsFormat = STATISTICS_NONE;
+    options->gridType = GRID_AUTO;
+    options->verifyEvery = 0;
+    options->infectedDuration = INFECTED_DURATION;
+    options->immuneDuration = IMMUNE_DURATION;
+    options->reorderEvery = -1;
+    options->curve = CURVE_MORTON;
+    options->fastForward = 0;
+
+    for(int i=TOTAL_ARGUMENT_COUNT;i<argc;i++) {
+        if(strncmp(argv[i], KERNELS_OPTION, strlen(KERNELS_OPTION)) == 0) {
+            const char *name = argv[i] + strlen(KERNELS_OPTION);
+            if(strcmp(name, "auto") == 0) {
+                options->kernelType = KERNELS_AUTO;
+            } else if(strcmp(name, "scalar") == 0) {
+                options->kernelType = KERNELS_SCALAR;
+            } else if(strcmp(name, "avx2") == 0) {
+                options->kernelType = KERNELS_AVX2;
+            } else if(strcmp(name, "avx512") == 0) {
+                options->kernelType = KERNELS_AVX512;
+            } else {
+                Usage();
             }
-            else {
-                person->statusDuration--;
+        } else if(strcmp(argv[i], CHECK_KERNELS_OPTION) == 0) {
+            options->checkKernels = 1;
+        } else if(strcmp(argv[i], FUSED_OPTION) == 0) {
+            options->fused = 1;
+        } else if(strcmp(argv[i], ACTIVE_OPTION) == 0) {
+            options->active = 1;
+        } else if(strcmp(argv[i], PTHREADS_OPTION) == 0) {
+            options->pthreads = 1;
+        } else if(strncmp(argv[i], BARRIER_OPTION, strlen(BARRIER_OPTION)) == 0) {
+            const char *type = argv[i] + strlen(BARRIER_OPTION);
+            if(strcmp(type, "spin") == 0) {
+                options->barrierType = BARRIER_SPIN;
+            } else if(strcmp(type, "pthread") == 0) {
+                options->barrierType = BARRIER_PTHREAD;
+            } else {
+                Usage();
             }
-            break;
-        case SUSCEPTIBLE:
-            break;
-        case IMMUNE:
-            if (person->statusDuration == 0) {
-                person->statusDuration = IMMUNE_DURATION;
+        } else if(strcmp(argv[i], BINARY_OUTPUT_OPTION) == 0) {
+            options->binaryOutput = 1;
+        } else if(strcmp(argv[i], CHECKPOINT_OPTION) == 0 && i + 1 < argc) {
+            options->checkpointEvery = atoi(argv[++i]);
+            if(options->checkpointEvery <= 0) {
+                Usage();
             }
-            else {
-                person->statusDuration--;
+        } else if(strcmp(argv[i], RESUME_OPTION) == 0) {
+            options->resume = 1;
+        } else if(strncmp(argv[i], STATISTICS_OPTION, strlen(STATISTICS_OPTION)) == 0) {
+            const char *format = argv[i] + strlen(STATISTICS_OPTION);
+            if(strcmp(format, "csv") == 0) {
+                options->statisticsFormat = STATISTICS_CSV;
+            } else if(strcmp(format, "binary") == 0) {
+                options->statisticsFormat = STATISTICS_BINARY;
+            } else {
+                Usage();
             }
-            break;
-        default:
-    }
-}
-
-void freeGrid(PersonNode ***grid, SimulationData *simulation) {
-    for(int i=0;i<simulation->maxXCoord;i++) {
-        free(grid[i]);
+        } else if(strcmp(argv[i], VERIFY_OPTION) == 0) {
+            options->verifyEvery = 1;
+        } else if(strncmp(argv[i], VERIFY_OPTION "=", strlen(VERIFY_OPTION "=")) == 0) {
+            options->verifyEvery = atoi(argv[i] + strlen(VERIFY_OPTION "="));
+            if(options->verifyEvery <= 0) {
+                Usage();
+            }
+        } else if(strncmp(argv[i], GRID_OPTION, strlen(GRID_OPTION)) == 0) {
+            const char *type = argv[i] + strlen(GRID_OPTION);
+            if(strcmp(type, "auto") == 0) {
+                options->gridType = GRID_AUTO;
+            } else if(strcmp(type, "dense") == 0) {
+                options->gridType = GRID_DENSE;
+            } else if(strcmp(type, "sparse") == 0) {
+                options->gridType = GRID_SPARSE;
+            } else {
+                Usage();
+            }
+        } else if(strcmp(argv[i], REORDER_OPTION) == 0) {
+            options->reorderEvery = 0;
+        } else if(strncmp(argv[i], REORDER_OPTION "=", strlen(REORDER_OPTION "=")) == 0) {
+            options->reorderEvery = atoi(argv[i] + strlen(REORDER_OPTION "="));
+            if(options->reorderEvery <= 0) {
+                Usage();
+            }
+        } else if(strcmp(argv[i], FAST_FORWARD_OPTION) == 0) {
+            options->fastForward = 1;
+        } else if(strncmp(argv[i], CURVE_OPTION, strlen(CURVE_OPTION)) == 0) {
+            const char *curve = argv[i] + strlen(CURVE_OPTION);
+            if(strcmp(curve, "morton") == 0) {
+                options->curve = CURVE_MORTON;
+            } else if(strcmp(curve, "hilbert") == 0) {
+                options->curve = CURVE_HILBERT;
+            } else {
+                Usage();
+            }
+        } else if(strncmp(argv[i], INFECTED_DURATION_OPTION, strlen(INFECTED_DURATION_OPTION)) == 0) {
+            options->infectedDuration = atoi(argv[i] + strlen(INFECTED_DURATION_OPTION));
+        } else if(strncmp(argv[i], IMMUNE_DURATION_OPTION, strlen(IMMUNE_DURATION_OPTION)) == 0) {
+            options->immuneDuration = atoi(argv[i] + strlen(IMMUNE_DURATION_OPTION));
+        } else {
+            Usage();
+        }
     }
-    free(grid);
-}
-
-int getIndexForChar(char *string, char c) {
-    int stringLength = strlen(string);
 
-    for(int i=0;i<stringLength;i++) {
-        if(string[i] == c) return i;
+    // pasii sariti nu au statistici, iar segmentele lui fastForward nu se potrivesc cu ale lui runEngine
+    if(options->fastForward && (options->statisticsFormat != STATISTICS_NONE || options->checkpointEvery > 0 || options->reorderEvery >= 0)) {
+        printf("%s nu poate fi folosit cu %s, %s sau %s\n", FAST_FORWARD_OPTION, STATISTICS_OPTION, CHECKPOINT_OPTION, REORDER_OPTION);
+        Usage();
     }
-
-    return -1;
 }
 
-char *buildOutputPath(char *inputPath, char *suffix) {
-    int inputPathLength = strlen(inputPath);
-    int suffixLength = strlen(suffix);
-
-    char *ret = malloc((inputPathLength + suffixLength + 1) * sizeof(char));
-    if(!ret) {
-        printf("Eroare la alocare string de output\n");
-        exit(-1);
-    }
-
-    int inputPathCutoff = getIndexForChar(inputPath, '.'); // vreau sa copiez fara .txt deci iau indexul punctului ca sa copiez doar pana acolo
-    if(inputPathCutoff == -1) {
-        printf("Fisierul nu are nume corespunzator - trebuie sa aiba o extensie cu '.'\n");
-        exit(-1);
+/*-----------------------------------------------------------------
+ * Function:  Print Fast Forward
+ * Purpose:   Show what fastForward found: the end of the epidemic, or the cycle of the state and how many of its repetitions were skipped
+ * In args:   forward
+ */
+void printFastForward(FastForward *forward) {
+    if(forward->extinctStep >= 0) {
+        printf("No infected or immune persons after step %d, movement computed up to step %d\n", forward->extinctStep, forward->simulationTime);
+    } else if(forward->cycleStart >= 0) {
+        printf("State repeats every %lld steps from step %d (movement period %lld), %lld cycles skipped\n", forward->cycleLength,
+               forward->cycleStart, forward->movementPeriod, forward->skippedCycles);
+    } else if(forward->movementPeriod == 0) {
+        printf("Movement period longer than the simulation, no steps skipped\n");
+    } else {
+        printf("No repeated state found (movement period %lld)\n", forward->movementPeriod);
     }
-
-    strncpy(ret, inputPath, inputPathCutoff);
-    ret[inputPathCutoff] = '\0';
-    strcat(ret, suffix);
-
-    return ret;
 }
-
-// for version 1
-// void computeNextStatus(Person *person, int index, SimulationData *simulation) {
-//     switch (person[index].status) {
-//         case INFECTED:
-//             for (int i=0; i<simulation->numberOfPersons; i++) {
-//                 if (i != index) {
-//                     if (person[i].status == SUSCEPTIBLE) {
-//                         if (person[i].coord.x == person[index].coord.x) {
-//                             if (person[i].coord.y == person[index].coord.y) {
-//                                 person[i].nextStatus = INFECTED;
-//                             }
-//                         }
-//                     }
-//                 }
-//             }
-//             if (person[index].statusDuration == 0) {
-//                 person[index].nextStatus = IMMUNE;
-//             }
-//             break;
-//         case IMMUNE:
-//             if (person[index].statusDuration == 0) {
-//                 person[index].nextStatus = SUSCEPTIBLE;
-//             }
-//             break;
-//         case SUSCEPTIBLE:
-//             break;
-//         default:
-//     }
-// }
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "epidemics.h"
+
+#ifdef PROFILE_PHASES
+
+// o faza masurata pe un thread, pentru trace
+typedef struct {
+    int phase;
+    double start;
+    double duration;
+}ProfileEvent;
+
+// masuratorile unui thread; fiecare thread scrie doar in ale lui, aliniate la CACHE_LINE_SIZE ca sa nu imparta linii de cache
+typedef struct {
+    double phaseStart[PHASE_COUNT];
+    double time[PHASE_COUNT];
+    long long items[PHASE_COUNT];
+    long long calls[PHASE_COUNT];
+    int eventCount;
+    int droppedEvents;
+    ProfileEvent *events;
+}ThreadProfile;
+
+static const char *phaseNames[PHASE_COUNT] = {"grid", "infection", "status", "location"};
+
+static ThreadProfile **threadProfiles;
+static int profileThreadCount;
+static const char *profileName;
+static double profileOrigin;
+static long long profileAllocations;
+static long long allocationsAtBegin;
+
+/*-----------------------------------------------------------------
+ * Function:  Profile Begin
+ * Purpose:   Start measuring the phases of one engine run, on at most threadCount threads; outside of profileBegin / profileEnd
+            profileStart and profileStop do nothing
+ * In args:   name (of the engine, for the report), threadCount
+ */
+void profileBegin(const char *name, int threadCount) {
+    profileName = name;
+    profileThreadCount = threadCount;
+    threadProfiles = malloc(threadCount * sizeof(ThreadProfile *));
+    if(!threadProfiles) {
+        printf("Eroare la alocare profil\n");
+        exit(-1);
+    }
+    for(int t=0;t<threadCount;t++) {
+        threadProfiles[t] = alignedArray(1, sizeof(ThreadProfile));
+        memset(threadProfiles[t], 0, sizeof(ThreadProfile));
+        threadProfiles[t]->events = malloc(PROFILE_MAX_EVENTS * sizeof(ProfileEvent));
+        if(!threadProfiles[t]->events) {
+            printf("Eroare la alocare profil\n");
+            exit(-1);
+        }
+    }
+    // alocarile facute aici nu sunt ale simularii
+    allocationsAtBegin = profileAllocations;
+    profileOrigin = omp_get_wtime();
+}
+
+void profileStart(int phase) {
+    int thread = omp_get_thread_num();
+    if(!threadProfiles || thread >= profileThreadCount) return;
+    threadProfiles[thread]->phaseStart[phase] = omp_get_wtime();
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Profile Stop
+ * Purpose:   End the phase started by the calling thread with profileStart, adding its time and the number of items
+            (persons or cells) it went through; the first PROFILE_MAX_EVENTS phases of every thread are kept for the trace
+ * In args:   phase, items
+ */
+void profileStop(int phase, long long items) {
+    int thread = omp_get_thread_num();
+    if(!threadProfiles || thread >= profileThreadCount) return;
+    ThreadProfile *profile = threadProfiles[thread];
+    double duration = omp_get_wtime() - profile->phaseStart[phase];
+
+    profile->time[phase] += duration;
+    profile->items[phase] += items;
+    profile->calls[phase]++;
+
+    if(profile->eventCount < PROFILE_MAX_EVENTS) {
+        ProfileEvent *event = &profile->events[profile->eventCount++];
+        event->phase = phase;
+        event->start = profile->phaseStart[phase] - profileOrigin;
+        event->duration = duration;
+    } else {
+        profile->droppedEvents++;
+    }
+}
+
+void profileAllocation() {
+    #pragma omp atomic
+    profileAllocations++;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Profile End
+ * Purpose:   Print the summary table of the run (per phase: calls, items, min / mean / max thread time
+            and load imbalance = max / mean over the threads that took part in the phase, then the time of every thread),
+            write the phases of every thread as a Chrome trace (chrome://tracing, Perfetto) at tracePath and free the measurements
+ * In args:   tracePath
+ */
+void profileEnd(const char *tracePath) {
+    long long allocations = profileAllocations - allocationsAtBegin;
+
+    printf("Profile %s (%d threads):\n", profileName, profileThreadCount);
+    printf("%-10s %8s %12s %10s %10s %10s %9s\n", "phase", "calls", "items", "min_s", "mean_s", "max_s", "imbalance");
+    for(int phase=0;phase<PHASE_COUNT;phase++) {
+        long long calls = 0, items = 0;
+        double min = 0, max = 0, sum = 0;
+        int threads = 0;
+        for(int t=0;t<profileThreadCount;t++) {
+            ThreadProfile *profile = threadProfiles[t];
+            if(profile->calls[phase] == 0) continue;
+            calls = profile->calls[phase] > calls ? profile->calls[phase] : calls;
+            items += profile->items[phase];
+            sum += profile->time[phase];
+            if(threads == 0 || profile->time[phase] < min) min = profile->time[phase];
+            if(profile->time[phase] > max) max = profile->time[phase];
+            threads++;
+        }
+        double mean = threads ? sum / threads : 0;
+        printf("%-10s %8lld %12lld %10.6f %10.6f %10.6f %9.3f\n", phaseNames[phase], calls, items, min, mean, max, mean > 0 ? max / mean : 0);
+    }
+
+    printf("%-10s", "thread");
+    for(int phase=0;phase<PHASE_COUNT;phase++) {
+        printf(" %10s", phaseNames[phase]);
+    }
+    printf("\n");
+    for(int t=0;t<profileThreadCount;t++) {
+        printf("%-10d", t);
+        for(int phase=0;phase<PHASE_COUNT;phase++) {
+            printf(" %10.6f", threadProfiles[t]->time[phase]);
+        }
+        printf("\n");
+    }
+    // bucla de timp nu mai aloca nimic (lista de persoane a fiecarei celule a fost inlocuita de CellIndex), asa ca ar trebui sa fie 0
+    printf("Allocations during the run (allocPopulation, allocGrid, alignedArray): %lld\n", allocations);
+
+    FILE *trace = fopen(tracePath, "w");
+    if(!trace) {
+        printf("File not found!\n");
+        exit(-1);
+    }
+    fprintf(trace, "{\"traceEvents\":[\n");
+    fprintf(trace, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"%s\"}}", profileName);
+    int dropped = 0;
+    for(int t=0;t<profileThreadCount;t++) {
+        ThreadProfile *profile = threadProfiles[t];
+        for(int e=0;e<profile->eventCount;e++) {
+            ProfileEvent *event = &profile->events[e];
+            fprintf(trace, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    phaseNames[event->phase], t, event->start * 1e6, event->duration * 1e6);
+        }
+        dropped += profile->droppedEvents;
+    }
+    fprintf(trace, "\n]}\n");
+    fclose(trace);
+    if(dropped > 0) {
+        printf("Trace %s: %d phases after the first %d of a thread were not written\n", tracePath, dropped, PROFILE_MAX_EVENTS);
+    }
+
+    for(int t=0;t<profileThreadCount;t++) {
+        free(threadProfiles[t]->events);
+        free(threadProfiles[t]);
+    }
+    free(threadProfiles);
+    threadProfiles = NULL;
+}
+
+#endif
@@ -0,0 +1,358 @@
+#include "epidemics.h"
+
+int barrierType = BARRIER_SPIN;
+
+/*-----------------------------------------------------------------
+ * Function:  Simulate Pthreads
+ * Purpose:   Simulates the POSIX threads version of the algorithm, with the same results as simulateParallel: the threads are started
+            at the first run on the grid and kept until freeGrid (the calling thread is thread 0), so the runs of fastForward or of
+            a server do not create them again; all threads go through all the steps together, with a barrier between the phases
+            instead of a parallel region for each of them; the persons and the cells are split statically, every thread keeps the
+            same block of persons for the grid, status and location phases
+ * In args:   grid (threadCount is the number of threads), population, simulation, statistics (can be NULL)
+ */
+void simulatePthreads(CellIndex *grid, Population *population, SimulationData *simulation, StatisticsStream *statistics) {
+    if(simulation->simulationTime <= simulation->startStep) return;
+
+    if(!grid->team) {
+        grid->team = startPthreadsTeam(grid);
+    }
+    PthreadsTeam *team = grid->team;
+
+    pthread_mutex_lock(&team->lock);
+    team->population = population;
+    team->simulation = simulation;
+    team->statistics = statistics;
+    for(int t=0;t<grid->threadCount;t++) {
+        PthreadsWorker *worker = &team->workers[t];
+        blockRange(simulation->numberOfPersons, KERNEL_BLOCK_SIZE, t, grid->threadCount, &worker->first, &worker->last);
+    }
+    team->generation++;
+    pthread_cond_broadcast(&team->start);
+    pthread_mutex_unlock(&team->lock);
+
+    pthreadsSteps(&team->workers[0]);
+    // populatia nu mai e atinsa de celelalte thread-uri dupa ce trec de bariera
+    phaseBarrierWait(&team->barrier, &team->workers[0].sense);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Start Pthreads Team
+ * Purpose:   Create the threads 1 .. threadCount - 1 of the grid, waiting for the first run of simulatePthreads
+ * In args:   grid
+ */
+PthreadsTeam *startPthreadsTeam(CellIndex *grid) {
+    char error[LOAD_ERROR_LENGTH];
+    PthreadsTeam *team = tryStartPthreadsTeam(grid, error);
+    if(!team) {
+        printf("%s\n", error);
+        exit(-1);
+    }
+
+    return team;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Try Start Pthreads Team
+ * Purpose:   startPthreadsTeam that gives back its error instead of stopping the program: when the memory, the barrier or
+            a thread cannot be had, the threads already started are stopped and everything is freed
+ * In args:   grid
+ * Out args:  error (LOAD_ERROR_LENGTH characters)
+ * Return:    the team, or NULL
+ */
+PthreadsTeam *tryStartPthreadsTeam(CellIndex *grid, char *error) {
+    int threadCount = grid->threadCount;
+    PthreadsTeam *team = malloc(sizeof(PthreadsTeam));
+    PthreadsWorker *workers = tryAlignedArray(threadCount, sizeof(PthreadsWorker));
+    if(!team || !workers) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Eroare la alocare thread-uri");
+        free(team);
+        free(workers);
+        return NULL;
+    }
+    if(tryInitPhaseBarrier(&team->barrier, barrierType, threadCount) != 0) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Bariera nu a putut fi creata");
+        free(team);
+        free(workers);
+        return NULL;
+    }
+    team->grid = grid;
+    team->population = NULL;
+    team->simulation = NULL;
+    team->statistics = NULL;
+    team->generation = 0;
+    team->stop = 0;
+    team->started = 1;
+    pthread_mutex_init(&team->lock, NULL);
+    pthread_cond_init(&team->start, NULL);
+    team->workers = workers;
+
+    for(int t=0;t<threadCount;t++) {
+        team->workers[t].team = team;
+        team->workers[t].thread = t;
+        team->workers[t].sense = 0;
+    }
+    for(int t=1;t<threadCount;t++) {
+        int result = pthread_create(&team->workers[t].handle, NULL, pthreadsWorker, &team->workers[t]);
+        if(result != 0) {
+            snprintf(error, LOAD_ERROR_LENGTH, "Thread-ul %d nu a putut fi pornit: %s", t, strerror(result));
+            stopPthreadsTeam(team);
+            return NULL;
+        }
+        team->started++;
+    }
+
+    return team;
+}
+
+void stopPthreadsTeam(PthreadsTeam *team) {
+    pthread_mutex_lock(&team->lock);
+    team->stop = 1;
+    pthread_cond_broadcast(&team->start);
+    pthread_mutex_unlock(&team->lock);
+
+    for(int t=1;t<team->started;t++) {
+        pthread_join(team->workers[t].handle, NULL);
+    }
+    destroyPhaseBarrier(&team->barrier);
+    pthread_mutex_destroy(&team->lock);
+    pthread_cond_destroy(&team->start);
+    free(team->workers);
+    free(team);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Pthreads Worker
+ * Purpose:   The threads 1 .. threadCount - 1 of a team: wait for a run, do its steps with thread 0, then wait at the final barrier
+ * In args:   argument (the PthreadsWorker of the thread)
+ */
+void *pthreadsWorker(void *argument) {
+    PthreadsWorker *worker = argument;
+    PthreadsTeam *team = worker->team;
+    long long generation = 0;
+
+    while(1) {
+        pthread_mutex_lock(&team->lock);
+        while(team->generation == generation && !team->stop) {
+            pthread_cond_wait(&team->start, &team->lock);
+        }
+        int stop = team->stop;
+        generation = team->generation;
+        pthread_mutex_unlock(&team->lock);
+        if(stop) break;
+
+        pthreadsSteps(worker);
+        phaseBarrierWait(&team->barrier, &worker->sense);
+    }
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Pthreads Steps
+ * Purpose:   All the steps of a run of simulatePthreads on one thread: grid, infection, then status and location of its persons;
+            after the infection barrier thread 0 adds the statistics of all threads
+ * In args:   worker
+ */
+void pthreadsSteps(PthreadsWorker *worker) {
+    PthreadsTeam *team = worker->team;
+    Population *population = team->population;
+    SimulationData *simulation = team->simulation;
+
+    for(int time=simulation->startStep;time<simulation->simulationTime;time++) {
+        pthreadsBuildGrid(worker);
+        pthreadsInfection(worker);
+        // status citeste nextStatus scris de thread-ul care are celula persoanei
+        phaseBarrierWait(&team->barrier, &worker->sense);
+
+        // statisticile thread-urilor sunt scrise din nou abia dupa barierele grid-ului de la pasul urmator
+        if(worker->thread == 0 && team->statistics) {
+            StepStatistics step = {.step = time + 1};
+            for(int t=0;t<team->grid->threadCount;t++) {
+                StepStatistics *partial = &team->workers[t].step;
+                step.infected += partial->infected;
+                step.susceptible += partial->susceptible;
+                step.immune += partial->immune;
+                step.newInfections += partial->newInfections;
+                step.occupiedCells += partial->occupiedCells;
+                if(partial->maxCellOccupancy > step.maxCellOccupancy) step.maxCellOccupancy = partial->maxCellOccupancy;
+            }
+            recordStep(team->statistics, &step);
+        }
+
+        // numararea din grid-ul pasului urmator citeste doar persoanele acestui thread, deci nu mai e nevoie de bariera
+        kernels.updateStatus(population, worker->first, worker->last, simulation);
+        kernels.updateLocation(population, worker->first, worker->last, simulation);
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Pthreads Build Grid
+ * Purpose:   The counting sort of updateGridParallel on the threads of simulatePthreads: every thread counts its persons, then
+            turns the histograms of a block of cells into per thread offsets, and the prefix sum and the list of occupied cells are
+            split by the same blocks (each block starts after the persons and occupied cells of the blocks before it) instead of
+            being done by one thread; a sparse grid is sorted by sortPersonCellsTeam
+ * In args:   worker
+ */
+void pthreadsBuildGrid(PthreadsWorker *worker) {
+    PthreadsTeam *team = worker->team;
+    CellIndex *grid = team->grid;
+    int thread = worker->thread;
+    int threadCount = grid->threadCount;
+
+    if(grid->sparse) {
+        sortPersonCellsTeam(grid, team->population, team->simulation, thread, threadCount, pthreadsBarrier, worker);
+        return;
+    }
+
+    int cellCount = grid->cellCount;
+    int *cellStart = grid->cellStart;
+    int *count = grid->threadCellCount + (size_t)thread * cellCount;
+    memset(count, 0, cellCount * sizeof(int));
+    countPersonCells(grid, team->population, team->simulation, worker->first, worker->last, count);
+    phaseBarrierWait(&team->barrier, &worker->sense);
+
+    // count[c] devine offsetul thread-ului in celula c, cellStart[c + 1] deocamdata numarul de persoane din celula
+    int cellFirst, cellLast;
+    blockRange(cellCount, KERNEL_BLOCK_SIZE, thread, threadCount, &cellFirst, &cellLast);
+    int persons = 0, occupied = 0;
+    for(int c=cellFirst;c<cellLast;c++) {
+        int sum = 0;
+        for(int t=0;t<threadCount;t++) {
+            int *slot = &grid->threadCellCount[(size_t)t * cellCount + c];
+            int value = *slot;
+            *slot = sum;
+            sum += value;
+        }
+        cellStart[c + 1] = sum;
+        persons += sum;
+        occupied += sum > 0;
+    }
+    worker->blockPersons = persons;
+    worker->blockOccupied = occupied;
+    phaseBarrierWait(&team->barrier, &worker->sense);
+
+    int offset = 0, occupiedIndex = 0;
+    for(int t=0;t<thread;t++) {
+        offset += team->workers[t].blockPersons;
+        occupiedIndex += team->workers[t].blockOccupied;
+    }
+    if(thread == 0) cellStart[0] = 0;
+    for(int c=cellFirst;c<cellLast;c++) {
+        if(cellStart[c + 1] > 0) {
+            grid->occupiedCells[occupiedIndex++] = c;
+        }
+        offset += cellStart[c + 1];
+        cellStart[c + 1] = offset;
+    }
+    if(thread == threadCount - 1) grid->occupiedCount = occupiedIndex;
+    phaseBarrierWait(&team->barrier, &worker->sense);
+
+    scatterPersons(grid, worker->first, worker->last, count);
+    phaseBarrierWait(&team->barrier, &worker->sense);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Pthreads Infection
+ * Purpose:   Compute the next status in the occupied cells of the thread: the cells are split statically so that every thread
+            gets about the same number of persons (the cells from the one holding person position numberOfPersons * thread / threadCount)
+ * In args:   worker
+ */
+void pthreadsInfection(PthreadsWorker *worker) {
+    PthreadsTeam *team = worker->team;
+    CellIndex *grid = team->grid;
+    int n = team->simulation->numberOfPersons;
+    int threadCount = grid->threadCount;
+
+    int first = firstCellFrom(grid, (int)((long long)n * worker->thread / threadCount));
+    int last = worker->thread == threadCount - 1 ? grid->occupiedCount : firstCellFrom(grid, (int)((long long)n * (worker->thread + 1) / threadCount));
+
+    StepStatistics step = {0};
+    for(int k=first;k<last;k++) {
+        int c = grid->occupiedCells[k];
+        computeCellNextStatus(&grid->personIndex[grid->cellStart[c]], grid->cellStart[c + 1] - grid->cellStart[c], team->population, &step);
+    }
+    worker->step = step;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  First Cell From
+ * Purpose:   Binary search in the occupied cells for the first one whose persons start at position or after it in personIndex
+ * In args:   grid, position
+ * Return:    an index in occupiedCells (occupiedCount if there is none)
+ */
+int firstCellFrom(CellIndex *grid, int position) {
+    int low = 0, high = grid->occupiedCount;
+    while(low < high) {
+        int middle = low + (high - low) / 2;
+        if(grid->cellStart[grid->occupiedCells[middle]] < position) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Try Init Phase Barrier
+ * Purpose:   Prepare a barrier of threadCount threads of the given BarrierTypes type
+ * In args:   type, threadCount
+ * Out args:  barrier
+ * Return:    0, or -1 if the pthread barrier could not be created
+ */
+int tryInitPhaseBarrier(PhaseBarrier *barrier, int type, int threadCount) {
+    barrier->type = type;
+    barrier->threadCount = threadCount;
+    atomic_init(&barrier->waiting, 0);
+    atomic_init(&barrier->sense, 0);
+    if(type == BARRIER_PTHREAD && pthread_barrier_init(&barrier->barrier, NULL, threadCount) != 0) return -1;
+    return 0;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Phase Barrier Wait
+ * Purpose:   Wait until all the threads of the barrier have reached it; the spin barrier is sense reversing: every thread flips
+            its local sense, the last one to arrive resets the counter and publishes the new sense, the others spin until they see it
+            (after BARRIER_SPINS_BEFORE_YIELD checks they give the processor away, so more threads than cores do not stall)
+ * In args:   barrier, localSense (of the calling thread)
+ */
+void phaseBarrierWait(PhaseBarrier *barrier, int *localSense) {
+    if(barrier->type == BARRIER_PTHREAD) {
+        pthread_barrier_wait(&barrier->barrier);
+        return;
+    }
+
+    int sense = !*localSense;
+    *localSense = sense;
+    if(atomic_fetch_add_explicit(&barrier->waiting, 1, memory_order_acq_rel) == barrier->threadCount - 1) {
+        atomic_store_explicit(&barrier->waiting, 0, memory_order_relaxed);
+        atomic_store_explicit(&barrier->sense, sense, memory_order_release);
+        return;
+    }
+
+    int spins = 0;
+    while(atomic_load_explicit(&barrier->sense, memory_order_acquire) != sense) {
+        if(++spins == BARRIER_SPINS_BEFORE_YIELD) {
+            sched_yield();
+            spins = 0;
+        } else {
+#ifdef HAVE_X86_KERNELS
+            _mm_pause();
+#endif
+        }
+    }
+}
+
+void destroyPhaseBarrier(PhaseBarrier *barrier) {
+    if(barrier->type == BARRIER_PTHREAD) {
+        pthread_barrier_destroy(&barrier->barrier);
+    }
+}
+
+// BarrierFunction pentru fazele comune cu OpenMP (sortPersonCellsTeam)
+void pthreadsBarrier(void *worker) {
+    PthreadsWorker *self = worker;
+    phaseBarrierWait(&self->team->barrier, &self->sense);
+}
@@ -0,0 +1,280 @@
+#include "epidemics.h"
+
+/*-----------------------------------------------------------------
+ * Function:  Alloc Person Order
+ * Purpose:   Allocate the state of the periodic reordering of a population of numberOfPersons persons along a space filling curve;
+            the reordered arrays are written in a second population (scratch), which then swaps its arrays with the simulated one
+ * In args:   numberOfPersons, every (steps between reorderings, 0 = adaptive), curve (CurveTypes)
+ */
+PersonOrder *allocPersonOrder(int numberOfPersons, int every, int curve) {
+    PersonOrder *order = malloc(sizeof(PersonOrder));
+    if(!order) {
+        printf("Eroare la alocare ordine persoane\n");
+        exit(-1);
+    }
+
+    order->every = every;
+    order->curve = curve;
+    order->numberOfPersons = numberOfPersons;
+    order->threadCount = omp_get_max_threads();
+    order->ordered = 0;
+    order->swapped = 0;
+    order->stepsSinceReorder = 0;
+    order->reorderCount = 0;
+    order->reorderTime = 0;
+    order->baseStepTime = 0;
+    order->lostTime = 0;
+    order->scratch = allocPopulation(numberOfPersons);
+    order->order = malloc((numberOfPersons + 1) * sizeof(int));
+    order->key = malloc((numberOfPersons + 1) * sizeof(uint64_t));
+    order->keyBuffer = malloc((numberOfPersons + 1) * sizeof(uint64_t));
+    order->value = malloc((numberOfPersons + 1) * sizeof(int));
+    order->valueBuffer = malloc((numberOfPersons + 1) * sizeof(int));
+    order->threadCounts = malloc((size_t)order->threadCount * SPARSE_RADIX_BUCKETS * sizeof(int));
+    if(!order->order || !order->key || !order->keyBuffer || !order->value || !order->valueBuffer || !order->threadCounts) {
+        printf("Eroare la alocare ordine persoane\n");
+        exit(-1);
+    }
+    for(int i=0;i<numberOfPersons;i++) {
+        order->order[i] = i;
+    }
+
+    return order;
+}
+
+void freePersonOrder(PersonOrder *order) {
+    freePopulation(order->scratch);
+    free(order->order);
+    free(order->key);
+    free(order->keyBuffer);
+    free(order->value);
+    free(order->valueBuffer);
+    free(order->threadCounts);
+    free(order);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Reorder Due
+ * Purpose:   Decide if the persons should be reordered before the next segment: always when they are in the original order,
+            then every order->every steps, or in the adaptive mode when the time lost since the last reordering (the steps
+            slower than the first ones after it) has grown to the time the reordering took
+ * In args:   order
+ */
+int reorderDue(PersonOrder *order) {
+    if(!order->ordered) return 1;
+    if(order->every > 0) return order->stepsSinceReorder >= order->every;
+    return order->lostTime >= order->reorderTime;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Reorder Segment
+ * Purpose:   How many steps can run before reorderDue has to be asked again
+ * In args:   order
+ */
+int reorderSegment(PersonOrder *order) {
+    return order->every > 0 ? order->every - order->stepsSinceReorder : REORDER_PROBE_STEPS;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Record Segment
+ * Purpose:   Count the steps of a segment run since the last reordering and, for the adaptive mode, the time they lost compared
+            to the time per step of the first segment after it
+ * In args:   order, steps, time (of the whole segment)
+ */
+void recordSegment(PersonOrder *order, int steps, double time) {
+    order->stepsSinceReorder += steps;
+    if(steps <= 0) return;
+
+    double stepTime = time / steps;
+    if(order->baseStepTime == 0) {
+        order->baseStepTime = stepTime;
+    } else if(stepTime > order->baseStepTime) {
+        order->lostTime += (stepTime - order->baseStepTime) * steps;
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Curve Key
+ * Purpose:   The position of the cell (x, y) on the curve of order: Morton (the bits of x and y interleaved) or Hilbert
+            (neighbouring positions are always neighbouring cells) over a square of 1 << levels cells
+ * In args:   curve, levels, x, y
+ */
+uint64_t curveKey(int curve, int levels, uint32_t x, uint32_t y) {
+    if(curve == CURVE_MORTON) {
+        return spreadBits(x) | spreadBits(y) << 1;
+    }
+
+    uint64_t key = 0;
+    uint32_t last = (1u << levels) - 1;
+    for(uint32_t s=1u<<(levels - 1);s>0;s>>=1) {
+        uint32_t rx = (x & s) != 0;
+        uint32_t ry = (y & s) != 0;
+        key += (uint64_t)s * s * ((3 * rx) ^ ry);
+        // rotire, ca sfertul urmator sa fie parcurs in aceeasi directie
+        if(ry == 0) {
+            if(rx == 1) {
+                x = last - x;
+                y = last - y;
+            }
+            uint32_t swap = x;
+            x = y;
+            y = swap;
+        }
+    }
+
+    return key;
+}
+
+// bitii lui value pe pozitiile pare ale rezultatului
+uint64_t spreadBits(uint32_t value) {
+    uint64_t bits = value;
+    bits = (bits | bits << 16) & 0x0000FFFF0000FFFFULL;
+    bits = (bits | bits << 8) & 0x00FF00FF00FF00FFULL;
+    bits = (bits | bits << 4) & 0x0F0F0F0F0F0F0F0FULL;
+    bits = (bits | bits << 2) & 0x3333333333333333ULL;
+    bits = (bits | bits << 1) & 0x5555555555555555ULL;
+    return bits;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Reorder Population
+ * Purpose:   Sort the persons by the curve key of their cell (stable, so persons of the same cell keep their order) and move
+            all their arrays in that order; order->order keeps the original index of every position, for restorePopulationOrder;
+            the results of the engines do not depend on the order of the persons, only the memory accesses do
+ * In args:   order, population, simulation
+ */
+void reorderPopulation(PersonOrder *order, Population *population, SimulationData *simulation) {
+    double start = omp_get_wtime();
+    int n = simulation->numberOfPersons;
+    int size = simulation->maxXCoord > simulation->maxYCoord ? simulation->maxXCoord : simulation->maxYCoord;
+    int levels = 1;
+    while(levels < 31 && ((uint32_t)(size - 1) >> levels) != 0) levels++;
+
+    #pragma omp parallel for num_threads(order->threadCount) schedule(static)
+    for(int i=0;i<n;i++) {
+        order->key[i] = curveKey(order->curve, levels, population->x[i], population->y[i]);
+        order->value[i] = i;
+    }
+    sortPersonKeys(order, n, 2 * levels);
+
+    // value[j] e pozitia de acum a persoanei care ajunge pe pozitia j
+    const int *from = order->value;
+    int *originalIndex = order->valueBuffer;
+    #pragma omp parallel for num_threads(order->threadCount) schedule(static)
+    for(int j=0;j<n;j++) {
+        originalIndex[j] = order->order[from[j]];
+    }
+    order->valueBuffer = order->order;
+    order->order = originalIndex;
+
+    movePersons(order, population, from, 0);
+
+    order->ordered = 1;
+    order->stepsSinceReorder = 0;
+    order->baseStepTime = 0;
+    order->lostTime = 0;
+    order->reorderCount++;
+    order->reorderTime = omp_get_wtime() - start;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Restore Population Order
+ * Purpose:   Put every person back at its original index, so the population can be written (or checkpointed) in the input order;
+            the population ends up with its own arrays again (a snapshot stays in its mapping)
+ * In args:   order, population
+ */
+void restorePopulationOrder(PersonOrder *order, Population *population) {
+    if(!order->ordered) return;
+
+    int n = order->numberOfPersons;
+    movePersons(order, population, order->order, 1);
+    if(order->swapped) {
+        // datele sunt inapoi in ordinea initiala, dar in array-urile lui scratch
+        copyPopulation(order->scratch, population, n);
+        swapPopulationArrays(population, order->scratch);
+        order->swapped = 0;
+    }
+
+    #pragma omp parallel for num_threads(order->threadCount) schedule(static)
+    for(int i=0;i<n;i++) {
+        order->order[i] = i;
+    }
+    order->ordered = 0;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Move Persons
+ * Purpose:   Write all the arrays of population in the arrays of order->scratch, person i going to position i of index (gather)
+            or person i going to position index[i] (scatter), then swap the arrays of the two populations
+ * In args:   order, population, index, scatter
+ */
+void movePersons(PersonOrder *order, Population *population, const int *index, int scatter) {
+    int n = order->numberOfPersons;
+    void **source[POPULATION_ARRAY_COUNT];
+    void **destination[POPULATION_ARRAY_COUNT];
+    populationArrays(population, source);
+    populationArrays(order->scratch, destination);
+
+    for(int k=0;k<POPULATION_ARRAY_COUNT;k++) {
+        size_t size = populationElementSize[k];
+        const char *from = *source[k];
+        char *to = *destination[k];
+        #pragma omp parallel for num_threads(order->threadCount) schedule(static)
+        for(int i=0;i<n;i++) {
+            size_t target = (size_t)(scatter ? index[i] : i) * size;
+            size_t origin = (size_t)(scatter ? i : index[i]) * size;
+            // dimensiuni constante, ca memcpy sa devina o singura incarcare
+            switch(size) {
+                case 1: memcpy(to + target, from + origin, 1); break;
+                case 2: memcpy(to + target, from + origin, 2); break;
+                case 4: memcpy(to + target, from + origin, 4); break;
+                default: memcpy(to + target, from + origin, size);
+            }
+        }
+    }
+
+    swapPopulationArrays(population, order->scratch);
+    order->swapped = !order->swapped;
+}
+
+void swapPopulationArrays(Population *first, Population *second) {
+    void **firstArrays[POPULATION_ARRAY_COUNT];
+    void **secondArrays[POPULATION_ARRAY_COUNT];
+    populationArrays(first, firstArrays);
+    populationArrays(second, secondArrays);
+    for(int k=0;k<POPULATION_ARRAY_COUNT;k++) {
+        void *swap = *firstArrays[k];
+        *firstArrays[k] = *secondArrays[k];
+        *secondArrays[k] = swap;
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Sort Person Keys
+ * Purpose:   Stable parallel LSD radix sort of the n pairs (key, value) of order, keyBits bits of the keys, SPARSE_RADIX_BITS
+            per pass (radixSortPairs on the threads of order); the sorted pairs end up in key and value
+ * In args:   order, n, keyBits
+ */
+void sortPersonKeys(PersonOrder *order, int n, int keyBits) {
+    int passes = (keyBits + SPARSE_RADIX_BITS - 1) / SPARSE_RADIX_BITS;
+
+    #pragma omp parallel num_threads(order->threadCount)
+    {
+        int thread = omp_get_thread_num();
+        int threadCount = omp_get_num_threads();
+        int first, last;
+        threadRange(n, KERNEL_BLOCK_SIZE, &first, &last);
+        radixSortPairs(order->key, order->value, order->keyBuffer, order->valueBuffer, passes, first, last, order->threadCounts, thread,
+                       threadCount, ompBarrier, NULL);
+    }
+
+    // cu un numar impar de treceri perechile sortate sunt in buffere
+    if(passes % 2) {
+        uint64_t *sortedKey = order->keyBuffer;
+        order->keyBuffer = order->key;
+        order->key = sortedKey;
+        int *sortedValue = order->valueBuffer;
+        order->valueBuffer = order->value;
+        order->value = sortedValue;
+    }
+}
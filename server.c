@@ -0,0 +1,419 @@
+#define _GNU_SOURCE // memfd_create
+#include "epidemics.h"
+
+/*-----------------------------------------------------------------
+ * Function:  Run Server
+ * Purpose:   Serve simulation jobs on the Unix domain socket at socketPath until a client sends SHUTDOWN: the populations stay loaded
+            between jobs (openSession), so a job only pays for its steps, and all jobs run one after another on the OpenMP threads
+            of the process, which are kept between the parallel regions; a client sends one command per line and gets one line back
+            ("OK ..." or "ERROR message"), after the payload of RUN stats or RESULT ("STATS bytes" / "RESULT bytes" and the bytes):
+              LOAD path [infectedDuration immuneDuration]   -> OK id numberOfPersons step
+              RUN id steps threads [parallel|fused|active|pthreads] [stats]   -> [STATS bytes + CSV] OK step time
+                (threads between 1 and threadCount)
+              RESULT id [standard|binary]                   -> RESULT bytes + the persons (or a snapshot), OK step
+              LIST                                          -> one "POPULATION id numberOfPersons step" line per population, OK count
+              UNLOAD id, QUIT (close the connection), SHUTDOWN (stop the server)
+            a command that fails (an invalid input, no memory, no threads, a failed write) is answered with ERROR and the server
+            keeps running with all its populations
+ * In args:   socketPath, threadCount (threads used to load the populations, the most a RUN can ask for)
+ * Return:    0 after SHUTDOWN
+ */
+int runServer(const char *socketPath, int threadCount) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(strlen(socketPath) >= sizeof(address.sun_path)) {
+        printf("Calea socket-ului este prea lunga: %s\n", socketPath);
+        exit(-1);
+    }
+    strcpy(address.sun_path, socketPath);
+
+    // un client care se deconecteaza in timpul raspunsului nu trebuie sa opreasca serverul
+    signal(SIGPIPE, SIG_IGN);
+
+    Server *server = calloc(1, sizeof(Server));
+    if(!server) {
+        printf("Eroare la alocare server\n");
+        exit(-1);
+    }
+    server->threadCount = threadCount;
+    server->running = 1;
+    for(int c=0;c<SERVER_MAX_CLIENTS;c++) {
+        server->clients[c].fd = -1;
+    }
+
+    server->listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(server->listenFd < 0) {
+        perror("Socket could not be created\n");
+        exit(-1);
+    }
+    unlink(socketPath);
+    if(bind(server->listenFd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(server->listenFd, SERVER_MAX_CLIENTS) != 0) {
+        perror("Socket could not be bound\n");
+        exit(-1);
+    }
+    printf("Listening on %s (%d threads, %s kernels)\n", socketPath, threadCount, kernels.name);
+    fflush(stdout);
+
+    struct pollfd fds[SERVER_MAX_CLIENTS + 1];
+    while(server->running) {
+        fds[0].fd = server->listenFd;
+        fds[0].events = POLLIN;
+        for(int c=0;c<SERVER_MAX_CLIENTS;c++) {
+            fds[c + 1].fd = server->clients[c].fd;
+            fds[c + 1].events = POLLIN;
+        }
+        if(poll(fds, SERVER_MAX_CLIENTS + 1, -1) < 0) {
+            perror("Poll failed\n");
+            exit(-1);
+        }
+
+        for(int c=0;c<SERVER_MAX_CLIENTS && server->running;c++) {
+            ServerClient *client = &server->clients[c];
+            if(client->fd >= 0 && fds[c + 1].revents != 0 && !readClient(server, client)) {
+                close(client->fd);
+                client->fd = -1;
+            }
+        }
+
+        if(server->running && (fds[0].revents & POLLIN)) {
+            int fd = accept(server->listenFd, NULL, NULL);
+            if(fd < 0) continue;
+            int c = 0;
+            while(c < SERVER_MAX_CLIENTS && server->clients[c].fd >= 0) c++;
+            if(c == SERVER_MAX_CLIENTS) {
+                serverReply(fd, "ERROR too many clients");
+                close(fd);
+                continue;
+            }
+            server->clients[c].fd = fd;
+            server->clients[c].length = 0;
+        }
+    }
+
+    for(int c=0;c<SERVER_MAX_CLIENTS;c++) {
+        if(server->clients[c].fd >= 0) close(server->clients[c].fd);
+    }
+    for(int id=0;id<SERVER_MAX_POPULATIONS;id++) {
+        if(server->sessions[id]) closeSession(server->sessions[id]);
+    }
+    close(server->listenFd);
+    unlink(socketPath);
+    free(server);
+    return 0;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Read Client
+ * Purpose:   Read what the client has sent and run every complete command in it; a partial line is kept for the next read
+ * In args:   server, client
+ * Return:    0 if the connection must be closed (end of file, error, QUIT, a line longer than SERVER_LINE_LENGTH)
+ */
+int readClient(Server *server, ServerClient *client) {
+    ssize_t count = read(client->fd, client->line + client->length, SERVER_LINE_LENGTH - 1 - client->length);
+    if(count <= 0) return 0;
+    client->length += count;
+
+    int start = 0;
+    for(int i=0;i<client->length;i++) {
+        if(client->line[i] != '\n') continue;
+        client->line[i] = '\0';
+        if(i > start && client->line[i - 1] == '\r') client->line[i - 1] = '\0';
+        if(!serverCommand(server, client->fd, client->line + start) || !server->running) return 0;
+        start = i + 1;
+    }
+
+    memmove(client->line, client->line + start, client->length - start);
+    client->length -= start;
+    if(client->length == SERVER_LINE_LENGTH - 1) {
+        serverReply(client->fd, "ERROR line too long");
+        return 0;
+    }
+    return 1;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Server Command
+ * Purpose:   Run one command of a client (see runServer) and send its answer
+ * In args:   server, fd (of the client), line
+ * Return:    0 if the connection must be closed
+ */
+int serverCommand(Server *server, int fd, char *line) {
+    char *arguments[8];
+    int count = 0;
+    char *save;
+    for(char *word=strtok_r(line, " \t", &save);word;word=strtok_r(NULL, " \t", &save)) {
+        if(count == (int)(sizeof(arguments) / sizeof(arguments[0]))) {
+            return serverReply(fd, "ERROR too many arguments") == 0;
+        }
+        arguments[count++] = word;
+    }
+    if(count == 0) return 1;
+
+    if(strcmp(arguments[0], "LOAD") == 0) {
+        return serverLoad(server, fd, arguments, count) == 0;
+    }
+    if(strcmp(arguments[0], "RUN") == 0) {
+        return serverRun(server, fd, arguments, count) == 0;
+    }
+    if(strcmp(arguments[0], "RESULT") == 0) {
+        return serverResult(server, fd, arguments, count) == 0;
+    }
+    if(strcmp(arguments[0], "LIST") == 0) {
+        int populations = 0;
+        for(int id=0;id<SERVER_MAX_POPULATIONS;id++) {
+            Session *session = server->sessions[id];
+            if(!session) continue;
+            populations++;
+            if(serverReply(fd, "POPULATION %d %d %d", id, session->simulation.numberOfPersons, session->simulation.startStep) != 0) return 0;
+        }
+        return serverReply(fd, "OK %d", populations) == 0;
+    }
+    if(strcmp(arguments[0], "UNLOAD") == 0) {
+        if(count != 2) {
+            return serverReply(fd, "ERROR usage: UNLOAD id") == 0;
+        }
+        Session *session = serverSession(server, fd, arguments[1]);
+        if(!session) return 1;
+        closeSession(session);
+        server->sessions[atoi(arguments[1])] = NULL;
+        return serverReply(fd, "OK") == 0;
+    }
+    if(strcmp(arguments[0], "QUIT") == 0) {
+        serverReply(fd, "OK");
+        return 0;
+    }
+    if(strcmp(arguments[0], "SHUTDOWN") == 0) {
+        server->running = 0;
+        serverReply(fd, "OK");
+        return 0;
+    }
+
+    return serverReply(fd, "ERROR unknown command %s", arguments[0]) == 0;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Server Load
+ * Purpose:   LOAD path [infectedDuration immuneDuration]: load a population in the first free place; an input that cannot be
+            loaded is answered with the error of openSession and the server keeps running
+ * In args:   server, fd, arguments, count
+ * Return:    0, or -1 if the answer could not be sent
+ */
+int serverLoad(Server *server, int fd, char **arguments, int count) {
+    if(count != 2 && count != 4) {
+        return serverReply(fd, "ERROR usage: LOAD path [infectedDuration immuneDuration]");
+    }
+    int infectedDuration = INFECTED_DURATION, immuneDuration = IMMUNE_DURATION;
+    if(count == 4 && (serverNumber(arguments[2], &infectedDuration) != 0 || serverNumber(arguments[3], &immuneDuration) != 0 ||
+                      infectedDuration < 1 || infectedDuration > UINT8_MAX || immuneDuration < 1 || immuneDuration > UINT8_MAX)) {
+        return serverReply(fd, "ERROR durations must be between 1 and %d", UINT8_MAX);
+    }
+
+    int id = 0;
+    while(id < SERVER_MAX_POPULATIONS && server->sessions[id]) id++;
+    if(id == SERVER_MAX_POPULATIONS) {
+        return serverReply(fd, "ERROR at most %d populations", SERVER_MAX_POPULATIONS);
+    }
+    if(access(arguments[1], R_OK) != 0) {
+        return serverReply(fd, "ERROR file not found: %s", arguments[1]);
+    }
+
+    char error[LOAD_ERROR_LENGTH];
+    Session *session = openSession(arguments[1], server->threadCount, infectedDuration, immuneDuration, error);
+    if(!session) {
+        return serverReply(fd, "ERROR %s", error);
+    }
+    server->sessions[id] = session;
+    return serverReply(fd, "OK %d %d %d", id, session->simulation.numberOfPersons, session->simulation.startStep);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Server Run
+ * Purpose:   RUN id steps threads [parallel|fused|active|pthreads] [stats]: simulate steps more steps of a population on 1 ..
+            threadCount (of the server) threads; with stats the counts of every step are gathered in a memory file and sent as
+            CSV before the answer; steps that would take the population past INT_MAX are refused
+ * In args:   server, fd, arguments, count
+ * Return:    0, or -1 if the answer could not be sent
+ */
+int serverRun(Server *server, int fd, char **arguments, int count) {
+    if(count < 4) {
+        return serverReply(fd, "ERROR usage: RUN id steps threads [parallel|fused|active|pthreads] [stats]");
+    }
+    Session *session = serverSession(server, fd, arguments[1]);
+    if(!session) return 0;
+    int steps, threads;
+    if(serverNumber(arguments[2], &steps) != 0) {
+        return serverReply(fd, "ERROR steps must be a number between 0 and %d", INT_MAX);
+    }
+    if(serverNumber(arguments[3], &threads) != 0 || threads < 1 || threads > server->threadCount) {
+        return serverReply(fd, "ERROR threads must be between 1 and %d", server->threadCount);
+    }
+    if(steps > INT_MAX - session->simulation.startStep) {
+        return serverReply(fd, "ERROR the population would go past step %d", INT_MAX);
+    }
+
+    SimulationEngine engine = simulateParallel;
+    int withStatistics = 0;
+    for(int i=4;i<count;i++) {
+        if(strcmp(arguments[i], "parallel") == 0) {
+            engine = simulateParallel;
+        } else if(strcmp(arguments[i], "fused") == 0) {
+            engine = simulateParallelFused;
+        } else if(strcmp(arguments[i], "active") == 0) {
+            engine = simulateParallelActive;
+        } else if(strcmp(arguments[i], "pthreads") == 0) {
+            engine = simulatePthreads;
+        } else if(strcmp(arguments[i], "stats") == 0) {
+            withStatistics = 1;
+        } else {
+            return serverReply(fd, "ERROR unknown option %s", arguments[i]);
+        }
+    }
+
+    char error[LOAD_ERROR_LENGTH];
+    int memoryFd = -1;
+    StatisticsStream *statistics = NULL;
+    if(withStatistics) {
+        memoryFd = memfd_create("epidemics_statistics", 0);
+        if(memoryFd < 0) {
+            return serverReply(fd, "ERROR memory file could not be created");
+        }
+        statistics = tryStreamStatistics(memoryFd, STATISTICS_CSV, &session->simulation, error);
+        if(!statistics) {
+            close(memoryFd);
+            return serverReply(fd, "ERROR %s", error);
+        }
+    }
+
+    double start = omp_get_wtime();
+    int step = stepSession(session, engine, steps, threads, statistics, error);
+    double time = omp_get_wtime() - start;
+
+    if(step < 0) {
+        if(statistics) {
+            // nu s-a simulat niciun pas, ramane doar eroarea lui stepSession
+            char ignored[LOAD_ERROR_LENGTH];
+            tryReleaseStatistics(statistics, ignored);
+            close(memoryFd);
+        }
+        return serverReply(fd, "ERROR %s", error);
+    }
+    if(statistics) {
+        // pasii au fost simulati chiar daca statisticile lor nu au putut fi scrise
+        if(tryReleaseStatistics(statistics, error) != 0) {
+            close(memoryFd);
+            return serverReply(fd, "ERROR %s (the population is at step %d)", error, step);
+        }
+        int sent = sendMemoryFile(fd, "STATS", memoryFd);
+        close(memoryFd);
+        if(sent != 0) return -1;
+    }
+    return serverReply(fd, "OK %d %lf", step, time);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Server Result
+ * Purpose:   RESULT id [standard|binary]: send the persons of a population in STANDARD_PRINT_FORMAT, or a snapshot of it
+ * In args:   server, fd, arguments, count
+ * Return:    0, or -1 if the answer could not be sent
+ */
+int serverResult(Server *server, int fd, char **arguments, int count) {
+    if(count != 2 && count != 3) {
+        return serverReply(fd, "ERROR usage: RESULT id [standard|binary]");
+    }
+    Session *session = serverSession(server, fd, arguments[1]);
+    if(!session) return 0;
+    int binary = count == 3 && strcmp(arguments[2], "binary") == 0;
+    if(count == 3 && !binary && strcmp(arguments[2], "standard") != 0) {
+        return serverReply(fd, "ERROR unknown format %s", arguments[2]);
+    }
+
+    int memoryFd = memfd_create("epidemics_result", 0);
+    if(memoryFd < 0) {
+        return serverReply(fd, "ERROR memory file could not be created");
+    }
+    char error[LOAD_ERROR_LENGTH];
+    int written = binary ? tryWriteSnapshot(memoryFd, session->population, &session->simulation, session->simulation.startStep, error)
+                         : tryPersonPrintToFile(memoryFd, session->population, &session->simulation, STANDARD_PRINT_FORMAT, error);
+    if(written != 0) {
+        close(memoryFd);
+        return serverReply(fd, "ERROR %s", error);
+    }
+    int sent = sendMemoryFile(fd, "RESULT", memoryFd);
+    close(memoryFd);
+    if(sent != 0) return -1;
+    return serverReply(fd, "OK %d", session->simulation.startStep);
+}
+
+// numarul intreg 0..INT_MAX din text, 0 daca e valid
+int serverNumber(const char *text, int *value) {
+    char *end;
+    errno = 0;
+    long number = strtol(text, &end, 10);
+    if(*end != '\0' || end == text || errno != 0 || number < 0 || number > INT_MAX) return -1;
+    *value = (int)number;
+    return 0;
+}
+
+// populatia cu id-ul dat, sau NULL dupa ce clientul a primit eroarea
+Session *serverSession(Server *server, int fd, const char *id) {
+    char *end;
+    long value = strtol(id, &end, 10);
+    if(*end != '\0' || end == id || value < 0 || value >= SERVER_MAX_POPULATIONS || !server->sessions[value]) {
+        serverReply(fd, "ERROR no population %s", id);
+        return NULL;
+    }
+    return server->sessions[value];
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Server Reply
+ * Purpose:   Send one line to a client, formatted like printf
+ * In args:   fd, format
+ * Return:    0, or -1 if the client is gone
+ */
+int serverReply(int fd, const char *format, ...) {
+    char line[SERVER_LINE_LENGTH];
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vsnprintf(line, sizeof(line) - 1, format, arguments);
+    va_end(arguments);
+    if(length > (int)sizeof(line) - 2) length = sizeof(line) - 2;
+    line[length++] = '\n';
+    return sendAll(fd, line, length);
+}
+
+// ca writeAll, dar o eroare inchide doar conexiunea clientului, nu tot serverul
+int sendAll(int fd, const void *buffer, size_t size) {
+    const char *data = buffer;
+    while(size > 0) {
+        ssize_t count = write(fd, data, size);
+        if(count < 0) {
+            // un semnal care intrerupe scrierea nu inseamna ca a plecat clientul
+            if(errno == EINTR) continue;
+            return -1;
+        }
+        data += count;
+        size -= count;
+    }
+    return 0;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Send Memory File
+ * Purpose:   Send the line "kind bytes" and then the whole memory file (with sendfile, without copying it through a buffer)
+ * In args:   fd (of the client), kind, memoryFd
+ * Return:    0, or -1 if the client is gone
+ */
+int sendMemoryFile(int fd, const char *kind, int memoryFd) {
+    off_t size = lseek(memoryFd, 0, SEEK_END);
+    if(serverReply(fd, "%s %lld", kind, (long long)size) != 0) return -1;
+
+    off_t offset = 0;
+    while(offset < size) {
+        ssize_t count = sendfile(fd, memoryFd, &offset, size - offset);
+        if(count < 0 && errno == EINTR) continue;
+        if(count <= 0) return -1;
+    }
+    return 0;
+}
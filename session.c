@@ -0,0 +1,107 @@
+#include "epidemics.h"
+
+/*-----------------------------------------------------------------
+ * Function:  Open Session
+ * Purpose:   Load a population (text input or snapshot) to be simulated a few steps at a time with stepSession, keeping the
+            population and its grid in memory between the calls; a bad input or a failed allocation is returned, the program
+            keeps running
+ * In args:   path, threadCount, infectedDuration, immuneDuration
+ * Out args:  error (LOAD_ERROR_LENGTH characters, the reason if the session could not be opened)
+ * Return:    the session, at the step of the input, or NULL
+ */
+Session *openSession(const char *path, int threadCount, int infectedDuration, int immuneDuration, char *error) {
+    if(infectedDuration < 1 || infectedDuration > UINT8_MAX || immuneDuration < 1 || immuneDuration > UINT8_MAX) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Duratele trebuie sa fie intre 1 si %d (infectat %d, imun %d)", UINT8_MAX, infectedDuration,
+                 immuneDuration);
+        return NULL;
+    }
+
+    Session *session = malloc(sizeof(Session));
+    if(!session) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Eroare la alocare sesiune");
+        return NULL;
+    }
+
+    omp_set_num_threads(threadCount);
+    session->population = tryLoadPopulation(path, &session->simulation, threadCount, error);
+    if(!session->population) {
+        free(session);
+        return NULL;
+    }
+    setDurations(session->population, &session->simulation, infectedDuration, immuneDuration);
+    session->simulation.simulationTime = session->simulation.startStep;
+    session->threadCount = threadCount;
+    session->grid = tryAllocGrid(&session->simulation, threadCount, GRID_AUTO, error);
+    if(!session->grid) {
+        freePopulation(session->population);
+        free(session);
+        return NULL;
+    }
+    initGrid(session->grid, session->population, &session->simulation);
+    return session;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Step Session
+ * Purpose:   Simulate steps more steps of the session with engine on threadCount threads (the grid is allocated again only when
+            the number of threads changes); steps that would take the session past INT_MAX, a grid and the memory or threads of
+            the engine (prepareEngine) that cannot be had are returned as errors, and the session stays as it was
+ * In args:   session, engine, steps, threadCount, statistics (can be NULL)
+ * Out args:  error (LOAD_ERROR_LENGTH characters)
+ * Return:    the step the session got to, or -1
+ */
+int stepSession(Session *session, SimulationEngine engine, int steps, int threadCount, StatisticsStream *statistics, char *error) {
+    if(steps < 0 || steps > INT_MAX - session->simulation.startStep) {
+        snprintf(error, LOAD_ERROR_LENGTH, "%d pasi de la pasul %d depasesc pasul %d", steps, session->simulation.startStep, INT_MAX);
+        return -1;
+    }
+    if(threadCount <= 0) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Numarul de thread-uri trebuie sa fie pozitiv");
+        return -1;
+    }
+
+    if(threadCount != session->threadCount) {
+        CellIndex *grid = tryAllocGrid(&session->simulation, threadCount, GRID_AUTO, error);
+        if(!grid) return -1;
+        freeGrid(session->grid);
+        session->grid = grid;
+        initGrid(session->grid, session->population, &session->simulation);
+        session->threadCount = threadCount;
+    }
+    if(prepareEngine(session->grid, engine, &session->simulation, error) != 0) return -1;
+
+    omp_set_num_threads(threadCount);
+    session->simulation.simulationTime = session->simulation.startStep + steps;
+    engine(session->grid, session->population, &session->simulation, statistics);
+    session->simulation.startStep = session->simulation.simulationTime;
+    return session->simulation.startStep;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Prepare Engine
+ * Purpose:   Allocate what engine would allocate at its first run on grid (the active set of simulateParallelActive, the threads
+            of simulatePthreads), so that a failure is given back here instead of stopping the program inside the engine
+ * In args:   grid, engine, simulation
+ * Out args:  error (LOAD_ERROR_LENGTH characters)
+ * Return:    0, or -1
+ */
+int prepareEngine(CellIndex *grid, SimulationEngine engine, SimulationData *simulation, char *error) {
+    if(engine == simulateParallelActive && !grid->active) {
+        grid->active = tryAllocActiveSet(simulation->numberOfPersons, grid->threadCount);
+        if(!grid->active) {
+            snprintf(error, LOAD_ERROR_LENGTH, "Eroare la alocare lista de persoane active");
+            return -1;
+        }
+    }
+    if(engine == simulatePthreads && !grid->team) {
+        grid->team = tryStartPthreadsTeam(grid, error);
+        if(!grid->team) return -1;
+    }
+    return 0;
+}
+
+void closeSession(Session *session) {
+    freeGrid(session->grid);
+    freePopulation(session->population);
+    free(session);
+}
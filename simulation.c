@@ -0,0 +1,1602 @@
+#include "epidemics.h"
+
+UpdateKernels kernels;
+
+/*-----------------------------------------------------------------
+ * Function:  Run Engine
+ * Purpose:   Run engine from simulation->startStep to simulation->simulationTime; with a checkpointer the run is cut in segments
+            that end on the multiples of checkpointer->every, and a checkpoint is started after every segment but the last one
+            (an engine only depends on the state of the persons, so running in segments gives the same result); with an order
+            the segments also end where the persons have to be reordered, and the population is back in its original order
+            for every checkpoint and at the end
+ * In args:   engine, grid, population, simulation, checkpointer (can be NULL), order (can be NULL), statistics (can be NULL)
+ */
+void runEngine(SimulationEngine engine, CellIndex *grid, Population *population, SimulationData *simulation, Checkpointer *checkpointer,
+               PersonOrder *order, StatisticsStream *statistics) {
+    if(!checkpointer && !order) {
+        engine(grid, population, simulation, statistics);
+        return;
+    }
+
+    SimulationData segment = *simulation;
+    while(segment.startStep < simulation->simulationTime) {
+        int stop = simulation->simulationTime;
+        if(checkpointer) {
+            int checkpointStep = (segment.startStep / checkpointer->every + 1) * checkpointer->every;
+            if(checkpointStep < stop) stop = checkpointStep;
+        }
+        if(order) {
+            if(reorderDue(order)) reorderPopulation(order, population, &segment);
+            if(segment.startStep + reorderSegment(order) < stop) stop = segment.startStep + reorderSegment(order);
+        }
+
+        segment.simulationTime = stop;
+        double start = omp_get_wtime();
+        engine(grid, population, &segment, statistics);
+        if(order) recordSegment(order, stop - segment.startStep, omp_get_wtime() - start);
+
+        segment.startStep = stop;
+        if(checkpointer && stop < simulation->simulationTime && stop % checkpointer->every == 0) {
+            if(order) restorePopulationOrder(order, population);
+            startCheckpoint(checkpointer, population, &segment);
+        }
+    }
+    if(checkpointer) finishCheckpoint(checkpointer);
+    if(order) restorePopulationOrder(order, population);
+}
+
+double elapsedSeconds(struct timespec *start, struct timespec *finish) {
+    double time = (finish->tv_sec - start->tv_sec);
+    time += (finish->tv_nsec - start->tv_nsec) / 1000000000.0;
+    return time;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Simulate Serial
+ * Purpose:   Simulates the serial version of the algorithm
+ * In args:   grid, population, simulation, statistics (can be NULL)
+ */
+void simulateSerial(CellIndex *grid, Population *population, SimulationData *simulation, StatisticsStream *statistics) {
+    // each time step
+    for(int time=simulation->startStep;time<simulation->simulationTime;time++) {
+        #ifdef DEBUG
+            personPrintToConsole(population, simulation);
+            printf("\n");
+        #endif
+
+        PROFILE_START(PHASE_GRID);
+        updateGrid(grid, population, simulation);
+        PROFILE_STOP(PHASE_GRID, simulation->numberOfPersons);
+    #ifdef DEBUG_GRID
+        printGrid(grid, population, simulation);
+        printf("\n");
+    #endif
+
+        // version 1 compute status
+        // for(int i=0;i<simulation->numberOfPersons;i++) {
+        //     computeNextStatus(person, i, simulation);
+        // }
+
+        StepStatistics step = {.step = time + 1};
+        PROFILE_START(PHASE_INFECTION);
+        computeNextStatus(grid, population, simulation, &step);
+        PROFILE_STOP(PHASE_INFECTION, simulation->numberOfPersons);
+        if(statistics) recordStep(statistics, &step);
+
+        PROFILE_START(PHASE_STATUS);
+        for(int i=0;i<simulation->numberOfPersons;i++) {
+            updateStatus(population, i, simulation);
+        }
+        PROFILE_STOP(PHASE_STATUS, simulation->numberOfPersons);
+
+        // update locations
+        PROFILE_START(PHASE_LOCATION);
+        for(int i=0;i<simulation->numberOfPersons;i++) {
+            updateLocation(population, i, simulation);
+        }
+        PROFILE_STOP(PHASE_LOCATION, simulation->numberOfPersons);
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Simulate Parallel
+ * Purpose:   Simulates the OpenMP version of the algorithm; same steps as simulateSerial, each of them split between the threads;
+            status and location updates go through the vectorized kernels selected in main
+ * In args:   grid, population, simulation, statistics (can be NULL)
+ */
+void simulateParallel(CellIndex *grid, Population *population, SimulationData *simulation, StatisticsStream *statistics) {
+    for(int time=simulation->startStep;time<simulation->simulationTime;time++) {
+        updateGridParallel(grid, population, simulation);
+
+        StepStatistics step = {.step = time + 1};
+        computeNextStatusParallel(grid, population, simulation, &step);
+        if(statistics) recordStep(statistics, &step);
+
+        // status si locatie folosesc campuri diferite, deci fiecare thread le face pe amandoua pe blocul lui de persoane
+        #pragma omp parallel num_threads(grid->threadCount)
+        {
+            int first, last;
+            threadRange(simulation->numberOfPersons, KERNEL_BLOCK_SIZE, &first, &last);
+            PROFILE_START(PHASE_STATUS);
+            kernels.updateStatus(population, first, last, simulation);
+            PROFILE_STOP(PHASE_STATUS, last - first);
+            PROFILE_START(PHASE_LOCATION);
+            kernels.updateLocation(population, first, last, simulation);
+            PROFILE_STOP(PHASE_LOCATION, last - first);
+        }
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Simulate Parallel Fused
+ * Purpose:   Same results as simulateParallel with fewer passes over the persons: the grid is built once before the first step, and after the
+            infection pass every thread takes its persons in blocks of FUSED_BLOCK_SIZE and, while a block is still in cache, updates
+            the status, the location and counts the new cell; only the scatter of the person indices is left for the next step's grid
+ * In args:   grid, population, simulation, statistics (can be NULL)
+ */
+void simulateParallelFused(CellIndex *grid, Population *population, SimulationData *simulation, StatisticsStream *statistics) {
+    if(simulation->simulationTime > simulation->startStep) {
+        updateGridParallel(grid, population, simulation);
+    }
+
+    for(int time=simulation->startStep;time<simulation->simulationTime;time++) {
+        StepStatistics step = {.step = time + 1};
+        computeNextStatusParallel(grid, population, simulation, &step);
+        if(statistics) recordStep(statistics, &step);
+
+        // dupa ultimul pas nu mai e nevoie de grid
+        int rebuildGrid = time + 1 < simulation->simulationTime;
+
+        #pragma omp parallel num_threads(grid->threadCount)
+        {
+            int first, last;
+            threadRange(simulation->numberOfPersons, KERNEL_BLOCK_SIZE, &first, &last);
+            // grid-ul rar nu are histograme pe celule, e sortat din nou dupa ce toate thread-urile si-au mutat persoanele
+            int countCells = rebuildGrid && !grid->sparse;
+            int *count = countCells ? grid->threadCellCount + (size_t)omp_get_thread_num() * grid->cellCount : NULL;
+
+            if(countCells) {
+                memset(count, 0, grid->cellCount * sizeof(int));
+            }
+            for(int blockStart=first;blockStart<last;blockStart+=FUSED_BLOCK_SIZE) {
+                int blockEnd = blockStart + FUSED_BLOCK_SIZE < last ? blockStart + FUSED_BLOCK_SIZE : last;
+                PROFILE_START(PHASE_STATUS);
+                kernels.updateStatus(population, blockStart, blockEnd, simulation);
+                PROFILE_STOP(PHASE_STATUS, blockEnd - blockStart);
+                PROFILE_START(PHASE_LOCATION);
+                kernels.updateLocation(population, blockStart, blockEnd, simulation);
+                PROFILE_STOP(PHASE_LOCATION, blockEnd - blockStart);
+                if(countCells) {
+                    PROFILE_START(PHASE_GRID);
+                    countPersonCells(grid, population, simulation, blockStart, blockEnd, count);
+                    PROFILE_STOP(PHASE_GRID, blockEnd - blockStart);
+                }
+            }
+
+            if(rebuildGrid) {
+                #pragma omp barrier
+                PROFILE_START(PHASE_GRID);
+                if(grid->sparse) {
+                    sortPersonCells(grid, population, simulation);
+                } else {
+                    buildCellOffsets(grid);
+                    scatterPersons(grid, first, last, count);
+                }
+                PROFILE_STOP(PHASE_GRID, 0);
+            }
+        }
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Simulate Parallel Active
+ * Purpose:   Same results as simulateParallel without the cell index: only the infected and immune persons (the active set) are kept
+            in a list, and at every step the cells of the infected ones go in a hash table; the dense pass over all persons
+            (which has to move them anyway) infects a susceptible person whose cell is in the table and then moves its block,
+            and the status update only goes through the active list, dropping the persons that become susceptible;
+            building the table and updating the status cost O(active), and the infection adds one probe of the table per
+            susceptible person to the pass that moves all persons (none once nobody is infected), instead of a cell index over
+            the grid and all persons; occupiedCells and maxCellOccupancy are not counted (-1)
+ * In args:   grid (only its threadCount and active set are used), population, simulation, statistics (can be NULL)
+ */
+void simulateParallelActive(CellIndex *grid, Population *population, SimulationData *simulation, StatisticsStream *statistics) {
+    int n = simulation->numberOfPersons;
+    if(!grid->active) {
+        grid->active = allocActiveSet(n, grid->threadCount);
+    }
+    ActiveSet *active = grid->active;
+
+    // lista se reface la fiecare rulare, populatia poate fi alta (checkpoint, benchmark)
+    active->count = 0;
+    active->infectedCount = 0;
+    for(int i=0;i<n;i++) {
+        if(population->status[i] != SUSCEPTIBLE) {
+            active->persons[active->count++] = i;
+            if(population->status[i] == INFECTED) active->infectedCount++;
+        }
+    }
+
+    for(int time=simulation->startStep;time<simulation->simulationTime;time++) {
+        int tableBits = 1;
+        while((1 << tableBits) < 2 * active->infectedCount || (1 << tableBits) < ACTIVE_TABLE_MIN_SIZE) tableBits++;
+        active->tableBits = tableBits;
+        int tableSize = 1 << tableBits;
+        int infected = 0, immune = 0, newInfections = 0;
+
+        #pragma omp parallel num_threads(grid->threadCount) reduction(+:infected, immune, newInfections)
+        {
+            int thread = omp_get_thread_num();
+            int threadCount = omp_get_num_threads();
+            const int *persons = active->persons;
+
+            PROFILE_START(PHASE_INFECTION);
+            #pragma omp for schedule(static)
+            for(int k=0;k<tableSize;k++) {
+                active->cellKeys[k] = EMPTY_CELL_KEY;
+            }
+            #pragma omp for schedule(static)
+            for(int k=0;k<active->count;k++) {
+                int p = persons[k];
+                if(population->status[p] == INFECTED) {
+                    insertInfectedCell(active, (uint64_t)population->x[p] * simulation->maxYCoord + population->y[p]);
+                }
+            }
+
+            // pasul dens: fiecare persoana e verificata in celula de la inceputul pasului, apoi blocul e mutat;
+            // fara infectati tabela e goala si nu mai e cautat nimic
+            int first, last;
+            threadRange(n, KERNEL_BLOCK_SIZE, &first, &last);
+            int found = 0;
+            int probe = active->infectedCount > 0;
+            for(int i=first;i<last && probe;i++) {
+                if(population->status[i] == SUSCEPTIBLE &&
+                   isInfectedCell(active, (uint64_t)population->x[i] * simulation->maxYCoord + population->y[i])) {
+                    population->nextStatus[i] = INFECTED;
+                    active->scratch[first + found++] = i;
+                }
+            }
+            PROFILE_STOP(PHASE_INFECTION, last - first);
+            PROFILE_START(PHASE_LOCATION);
+            kernels.updateLocation(population, first, last, simulation);
+            PROFILE_STOP(PHASE_LOCATION, last - first);
+            newInfections += found;
+
+            // cei nou infectati sunt adaugati dupa persoanele active, in ordinea blocurilor
+            active->threadFound[thread] = found;
+            #pragma omp barrier
+            int offset = active->count;
+            for(int t=0;t<thread;t++) offset += active->threadFound[t];
+            memcpy(&active->persons[offset], &active->scratch[first], found * sizeof(int));
+            int total = active->count;
+            for(int t=0;t<threadCount;t++) total += active->threadFound[t];
+            #pragma omp barrier
+
+            PROFILE_START(PHASE_STATUS);
+            threadRange(total, KERNEL_BLOCK_SIZE, &first, &last);
+            int kept = 0;
+            for(int k=first;k<last;k++) {
+                int p = persons[k];
+                if(population->statusDuration[p] == 0) {
+                    if(population->status[p] == INFECTED) population->nextStatus[p] = IMMUNE;
+                    else if(population->status[p] == IMMUNE) population->nextStatus[p] = SUSCEPTIBLE;
+                }
+                updateStatus(population, p, simulation);
+                if(population->status[p] != SUSCEPTIBLE) {
+                    active->scratch[first + kept++] = p;
+                    if(population->status[p] == INFECTED) infected++;
+                    else immune++;
+                }
+            }
+            PROFILE_STOP(PHASE_STATUS, last - first);
+
+            // lista compactata: persoanele pastrate de fiecare thread, dupa ale celor dinainte
+            active->threadFound[thread] = kept;
+            #pragma omp barrier
+            offset = 0;
+            for(int t=0;t<thread;t++) offset += active->threadFound[t];
+            memcpy(&active->persons[offset], &active->scratch[first], kept * sizeof(int));
+            if(thread == threadCount - 1) {
+                active->count = offset + kept;
+            }
+        }
+        active->infectedCount = infected;
+
+        if(statistics) {
+            StepStatistics step = {.step = time + 1, .infected = infected, .susceptible = n - infected - immune, .immune = immune,
+                                   .newInfections = newInfections, .occupiedCells = -1, .maxCellOccupancy = -1};
+            recordStep(statistics, &step);
+        }
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Insert Infected Cell
+ * Purpose:   Add the key of a cell to the table of the current step (linear probing); the threads insert at the same time,
+            a free slot is taken with compare and swap
+ * In args:   active, key
+ */
+void insertInfectedCell(ActiveSet *active, uint64_t key) {
+    uint64_t mask = ((uint64_t)1 << active->tableBits) - 1;
+    uint64_t slot = (key * 0x9E3779B97F4A7C15ULL) >> (64 - active->tableBits);
+    while(1) {
+        uint64_t current = __atomic_load_n(&active->cellKeys[slot], __ATOMIC_RELAXED);
+        if(current == key) return;
+        if(current == EMPTY_CELL_KEY) {
+            if(__atomic_compare_exchange_n(&active->cellKeys[slot], &current, key, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) return;
+            // alt thread a luat pozitia; daca a pus aceeasi celula, e deja in tabela
+            if(current == key) return;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+int isInfectedCell(ActiveSet *active, uint64_t key) {
+    uint64_t mask = ((uint64_t)1 << active->tableBits) - 1;
+    uint64_t slot = (key * 0x9E3779B97F4A7C15ULL) >> (64 - active->tableBits);
+    while(active->cellKeys[slot] != EMPTY_CELL_KEY) {
+        if(active->cellKeys[slot] == key) return 1;
+        slot = (slot + 1) & mask;
+    }
+    return 0;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Init Grid
+ * Purpose:   Mark all the cells of the grid as empty; persons are put in their cells by updateGrid at the start of every step
+ * In args:   grid, population, simulation
+ */
+void initGrid(CellIndex *grid, Population *population, SimulationData *simulation) {
+    memset(grid->cellStart, 0, (grid->cellCount + 1) * sizeof(int));
+}
+
+void printGrid(CellIndex *grid, Population *population, SimulationData *simulation) {
+    if(grid->sparse) {
+        for(int c=0;c<grid->cellCount;c++) {
+            int person = grid->personIndex[grid->cellStart[c]];
+            printf("[%d][%d]: ", population->x[person], population->y[person]);
+            printList(&grid->personIndex[grid->cellStart[c]], grid->cellStart[c + 1] - grid->cellStart[c], population);
+        }
+        return;
+    }
+
+    for(int i=0;i<simulation->maxXCoord;i++) {
+        for(int j=0;j<simulation->maxYCoord;j++) {
+            int cell = i * simulation->maxYCoord + j;
+            printf("[%d][%d]: ", i, j);
+            printList(&grid->personIndex[grid->cellStart[cell]], grid->cellStart[cell + 1] - grid->cellStart[cell], population);
+        }
+        printf("\n");
+    }
+}
+
+void printList(const int *cellPersons, int cellSize, Population *population) {
+    for(int k=0;k<cellSize;k++) {
+        printf("(%d, %d) ", cellPersons[k] + 1, population->status[cellPersons[k]]);
+    }
+    printf("\n");
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Update Grid
+ * Purpose:   Rebuild the cell index from the x and y coordinates of all persons with a counting sort on the cell id:
+            count the persons of every cell, turn the counts into offsets with a prefix sum, then scatter the person indices;
+            nothing is allocated, the arrays of the index are reused every step; a sparse grid is sorted by sortPersonCellsTeam
+            instead, on the calling thread only
+ * In args:   grid, population, simulation
+ */
+void updateGrid(CellIndex *grid, Population *population, SimulationData *simulation) {
+    if(grid->sparse) {
+        sortPersonCellsTeam(grid, population, simulation, 0, 1, noBarrier, NULL);
+        return;
+    }
+
+    int *cellStart = grid->cellStart;
+    memset(cellStart, 0, (grid->cellCount + 1) * sizeof(int));
+
+    // numar persoanele din fiecare celula
+    for(int i=0;i<simulation->numberOfPersons;i++) {
+        int cell = (population->x[i] - grid->firstRow) * simulation->maxYCoord + population->y[i];
+        grid->personCell[i] = cell;
+        cellStart[cell + 1]++;
+    }
+
+    for(int c=0;c<grid->cellCount;c++) {
+        cellStart[c + 1] += cellStart[c];
+    }
+
+    // pun fiecare persoana pe urmatoarea pozitie libera din celula ei
+    memcpy(grid->cellCursor, cellStart, grid->cellCount * sizeof(int));
+    for(int i=0;i<simulation->numberOfPersons;i++) {
+        grid->personIndex[grid->cellCursor[grid->personCell[i]]++] = i;
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Update Grid Parallel
+ * Purpose:   Same counting sort as updateGrid, split between threads: every thread counts its own block of persons in its own histogram,
+            the histograms are turned into per thread offsets inside every cell, and every thread scatters its block at those offsets;
+            the persons of a cell end up in the same (increasing) order as in the serial version; a sparse grid is sorted
+            by sortPersonCells on all the threads
+ * In args:   grid, population, simulation
+ */
+void updateGridParallel(CellIndex *grid, Population *population, SimulationData *simulation) {
+    #pragma omp parallel num_threads(grid->threadCount)
+    {
+        int first, last;
+        threadRange(simulation->numberOfPersons, KERNEL_BLOCK_SIZE, &first, &last);
+        if(grid->sparse) {
+            PROFILE_START(PHASE_GRID);
+            sortPersonCells(grid, population, simulation);
+            PROFILE_STOP(PHASE_GRID, last - first);
+        } else {
+            int *count = grid->threadCellCount + (size_t)omp_get_thread_num() * grid->cellCount;
+
+            // fara asteptarea de la barrier, ca timpul fiecarui thread sa arate cat de inegal e impartit lucrul
+            PROFILE_START(PHASE_GRID);
+            memset(count, 0, grid->cellCount * sizeof(int));
+            countPersonCells(grid, population, simulation, first, last, count);
+            PROFILE_STOP(PHASE_GRID, last - first);
+            #pragma omp barrier
+
+            PROFILE_START(PHASE_GRID);
+            buildCellOffsets(grid);
+            scatterPersons(grid, first, last, count);
+            PROFILE_STOP(PHASE_GRID, 0);
+        }
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Count Person Cells
+ * Purpose:   Save the cell of every person in [first, last) and count it in the histogram of the calling thread
+ * In args:   grid, population, simulation, first, last
+ * Out args:  count
+ */
+void countPersonCells(CellIndex *grid, Population *population, SimulationData *simulation, int first, int last, int *count) {
+    for(int i=first;i<last;i++) {
+        int cell = (population->x[i] - grid->firstRow) * simulation->maxYCoord + population->y[i];
+        grid->personCell[i] = cell;
+        count[cell]++;
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Build Cell Offsets
+ * Purpose:   Turn the per thread histograms into cellStart and per thread offsets inside every cell, and rebuild the list of occupied cells;
+            must be called by all the threads of a parallel region, after all of them have finished counting
+ * In args:   grid
+ */
+void buildCellOffsets(CellIndex *grid) {
+    int cellCount = grid->cellCount;
+    int threadCount = omp_get_num_threads();
+    int *cellStart = grid->cellStart;
+
+    // count[c] devine offsetul thread-ului in celula c, iar cellStart[c + 1] numarul total de persoane din celula
+    #pragma omp for schedule(static)
+    for(int c=0;c<cellCount;c++) {
+        int sum = 0;
+        for(int t=0;t<threadCount;t++) {
+            int *slot = &grid->threadCellCount[(size_t)t * cellCount + c];
+            int value = *slot;
+            *slot = sum;
+            sum += value;
+        }
+        cellStart[c + 1] = sum;
+    }
+
+    // in acelasi timp cu suma prefix retin celulele ocupate, singurele prin care trece computeNextStatusParallel
+    #pragma omp single
+    {
+        int occupiedCount = 0;
+        cellStart[0] = 0;
+        for(int c=0;c<cellCount;c++) {
+            if(cellStart[c + 1] > 0) {
+                grid->occupiedCells[occupiedCount++] = c;
+            }
+            cellStart[c + 1] += cellStart[c];
+        }
+        grid->occupiedCount = occupiedCount;
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Scatter Persons
+ * Purpose:   Write the indices of the persons in [first, last) at the offsets of the calling thread inside their cells
+ * In args:   grid, first, last, count
+ */
+void scatterPersons(CellIndex *grid, int first, int last, int *count) {
+    for(int i=first;i<last;i++) {
+        int cell = grid->personCell[i];
+        grid->personIndex[grid->cellStart[cell] + count[cell]++] = i;
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Sort Person Cells
+ * Purpose:   Build a sparse cell index: sort the persons by the key (x - firstRow) * maxYCoord + y of their cell with a stable LSD radix sort
+            (keyPasses passes of SPARSE_RADIX_BITS, every thread with its own histogram, like updateGridParallel), then give every run
+            of equal keys a cellStart offset; the persons of a cell stay in increasing order, so the cells are visited exactly as
+            in the dense index, only without the empty ones; must be called by all the threads of a parallel region
+ * In args:   grid, population, simulation
+ */
+void sortPersonCells(CellIndex *grid, Population *population, SimulationData *simulation) {
+    sortPersonCellsTeam(grid, population, simulation, omp_get_thread_num(), omp_get_num_threads(), ompBarrier, NULL);
+}
+
+void ompBarrier(void *unused) {
+    (void)unused;
+    #pragma omp barrier
+}
+
+// bariera unei echipe de un singur thread
+void noBarrier(void *unused) {
+    (void)unused;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Sort Person Cells Team
+ * Purpose:   The radix sort of sortPersonCells for any team of threads: thread (0 .. threadCount - 1) is the calling thread, and
+            wait(barrier) must return only after all threadCount threads have called it (an OpenMP or a pthreads barrier)
+ * In args:   grid, population, simulation, thread, threadCount, wait, barrier
+ */
+void sortPersonCellsTeam(CellIndex *grid, Population *population, SimulationData *simulation, int thread, int threadCount,
+                         BarrierFunction wait, void *barrier) {
+    int n = simulation->numberOfPersons;
+    int first, last;
+    blockRange(n, KERNEL_BLOCK_SIZE, thread, threadCount, &first, &last);
+
+    // fiecare trecere scrie in celalalt buffer; cu un numar impar de treceri pornesc din buffere, ca indicii sa ajunga in personIndex
+    int odd = grid->keyPasses % 2;
+    uint64_t *key = odd ? grid->keyBuffer : grid->personKey;
+    uint64_t *nextKey = odd ? grid->personKey : grid->keyBuffer;
+    int *index = odd ? grid->indexBuffer : grid->personIndex;
+    int *nextIndex = odd ? grid->personIndex : grid->indexBuffer;
+
+    for(int i=first;i<last;i++) {
+        key[i] = (uint64_t)(population->x[i] - grid->firstRow) * simulation->maxYCoord + population->y[i];
+        index[i] = i;
+    }
+
+    radixSortPairs(key, index, nextKey, nextIndex, grid->keyPasses, first, last, grid->threadCellCount, thread, threadCount, wait, barrier);
+    key = grid->personKey;
+
+    // celulele ocupate incep unde se schimba cheia; fiecare thread numara inceputurile din partea lui, apoi le scrie dupa ale celor dinainte
+    int *count = grid->threadCellCount + (size_t)thread * SPARSE_RADIX_BUCKETS;
+    int cells = 0;
+    for(int p=first;p<last;p++) {
+        if(p == 0 || key[p] != key[p - 1]) cells++;
+    }
+    count[0] = cells;
+    wait(barrier);
+
+    int cell = 0;
+    for(int t=0;t<thread;t++) {
+        cell += grid->threadCellCount[(size_t)t * SPARSE_RADIX_BUCKETS];
+    }
+    for(int p=first;p<last;p++) {
+        if(p == 0 || key[p] != key[p - 1]) grid->cellStart[cell++] = p;
+    }
+    if(thread == threadCount - 1) {
+        grid->cellStart[cell] = n;
+        grid->cellCount = cell;
+        grid->occupiedCount = cell;
+    }
+    wait(barrier);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Radix Sort Pairs
+ * Purpose:   The passes of a stable LSD radix sort of the pairs (key, value), SPARSE_RADIX_BITS per pass, for any team of threads:
+            thread sorts the pairs of [first, last) with its own histogram of threadCounts (threadCount x SPARSE_RADIX_BUCKETS) and
+            wait(barrier) must return only after all threadCount threads have called it; every pass writes in the other pair
+            of arrays, so the sorted pairs are in key and value after an even number of passes and in keyBuffer and valueBuffer
+            after an odd one
+ * In args:   key, value, keyBuffer, valueBuffer, passes, first, last, threadCounts, thread, threadCount, wait, barrier
+ */
+void radixSortPairs(uint64_t *key, int *value, uint64_t *keyBuffer, int *valueBuffer, int passes, int first, int last, int *threadCounts,
+                    int thread, int threadCount, BarrierFunction wait, void *barrier) {
+    int *count = threadCounts + (size_t)thread * SPARSE_RADIX_BUCKETS;
+    for(int pass=0;pass<passes;pass++) {
+        int shift = pass * SPARSE_RADIX_BITS;
+        memset(count, 0, SPARSE_RADIX_BUCKETS * sizeof(int));
+        for(int i=first;i<last;i++) {
+            count[(key[i] >> shift) & (SPARSE_RADIX_BUCKETS - 1)]++;
+        }
+        wait(barrier);
+
+        // count[d] devine pozitia primei perechi a thread-ului cu cifra d: cifrele in ordine, iar pentru o cifra thread-urile in ordine
+        if(thread == 0) {
+            int offset = 0;
+            for(int d=0;d<SPARSE_RADIX_BUCKETS;d++) {
+                for(int t=0;t<threadCount;t++) {
+                    int *slot = &threadCounts[(size_t)t * SPARSE_RADIX_BUCKETS + d];
+                    int digitCount = *slot;
+                    *slot = offset;
+                    offset += digitCount;
+                }
+            }
+        }
+        wait(barrier);
+
+        for(int i=first;i<last;i++) {
+            int position = count[(key[i] >> shift) & (SPARSE_RADIX_BUCKETS - 1)]++;
+            keyBuffer[position] = key[i];
+            valueBuffer[position] = value[i];
+        }
+        wait(barrier);
+
+        uint64_t *sortedKey = keyBuffer;
+        keyBuffer = key;
+        key = sortedKey;
+        int *sortedValue = valueBuffer;
+        valueBuffer = value;
+        value = sortedValue;
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Update Location
+ * Purpose:   Update the location of the person at index and take care of out of test area; the new coordinate is computed on int,
+            so it can go out of the grid (and of the range of coord_t) before being clamped
+ * In args:   population, index, simulation
+ */
+void updateLocation(Population *population, int index, SimulationData *simulation) {
+    int x = population->x[index];
+    int y = population->y[index];
+    int movementAmplitude = population->movementAmplitude[index];
+
+    switch (population->movementDirection[index]) {
+        case NORTH:
+            x += movementAmplitude;
+            if (x >= simulation->maxXCoord) {
+                x = simulation->maxXCoord - 1;
+                population->movementDirection[index] ^= 1;
+            }
+            population->x[index] = x;
+            break;
+        case SOUTH:
+            x -= movementAmplitude;
+            if (x < 0) {
+                x = 0;
+                population->movementDirection[index] ^= 1;
+            }
+            population->x[index] = x;
+            break;
+        case EAST:
+            y += movementAmplitude;
+            if (y >= simulation->maxYCoord) {
+                y = simulation->maxYCoord - 1;
+                population->movementDirection[index] ^= 1;
+            }
+            population->y[index] = y;
+            break;
+        case WEST:
+            y -= movementAmplitude;
+            if (y < 0) {
+                y = 0;
+                population->movementDirection[index] ^= 1;
+            }
+            population->y[index] = y;
+            break;
+        default:
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Compute NextStatus
+ * Purpose:   Compute the next status for a person
+ * In args:   grid, population, simulation
+ * Out args:  step (the counts of the step are added to it)
+ */
+void computeNextStatus(CellIndex *grid, Population *population, SimulationData *simulation, StepStatistics *step) {
+    for(int c=0;c<grid->cellCount;c++) {
+        int cellSize = grid->cellStart[c + 1] - grid->cellStart[c];
+        if(cellSize == 0) continue;
+        computeCellNextStatus(&grid->personIndex[grid->cellStart[c]], cellSize, population, step);
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Compute NextStatus Parallel
+ * Purpose:   Compute the next status for all persons, splitting the occupied cells of the grid (built by updateGridParallel) between threads;
+            empty cells are skipped entirely and the cells are handed out dynamically in small chunks, so a thread that gets crowded
+            cells does not hold back the others; a person is in exactly one cell, so threads never write the same person
+ * In args:   grid, population, simulation
+ * Out args:  step (the counts of the step are added to it, as reductions of the same loop)
+ */
+void computeNextStatusParallel(CellIndex *grid, Population *population, SimulationData *simulation, StepStatistics *step) {
+    const int *occupiedCells = grid->occupiedCells;
+    int chunk = grid->occupiedCount / (grid->threadCount * INFECTION_CHUNKS_PER_THREAD);
+    if(chunk < 1) chunk = 1;
+    int infected = 0, susceptible = 0, immune = 0, newInfections = 0, maxCellOccupancy = 0;
+
+    // reducerile sunt pe regiune, ca fiecare thread sa-si poata masura bucla fara asteptarea de la sfarsitul ei
+    #pragma omp parallel num_threads(grid->threadCount) \
+        reduction(+:infected, susceptible, immune, newInfections) reduction(max:maxCellOccupancy)
+    {
+        PROFILE_START(PHASE_INFECTION);
+        #pragma omp for schedule(dynamic, chunk) nowait
+        for(int k=0;k<grid->occupiedCount;k++) {
+            int c = occupiedCells[k];
+            StepStatistics cell = {0};
+            computeCellNextStatus(&grid->personIndex[grid->cellStart[c]], grid->cellStart[c + 1] - grid->cellStart[c], population, &cell);
+            infected += cell.infected;
+            susceptible += cell.susceptible;
+            immune += cell.immune;
+            newInfections += cell.newInfections;
+            if(cell.maxCellOccupancy > maxCellOccupancy) maxCellOccupancy = cell.maxCellOccupancy;
+        }
+        // persoanele din celulele acestui thread
+        PROFILE_STOP(PHASE_INFECTION, infected + susceptible + immune);
+    }
+
+    step->infected += infected;
+    step->susceptible += susceptible;
+    step->immune += immune;
+    step->newInfections += newInfections;
+    step->occupiedCells += grid->occupiedCount;
+    if(maxCellOccupancy > step->maxCellOccupancy) step->maxCellOccupancy = maxCellOccupancy;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Compute Cell NextStatus
+ * Purpose:   Compute the next status for the cellSize persons of one cell of the grid; the statuses the persons of the cell
+            will have after the step are counted from the same loop, without another pass over them
+ * In args:   cellPersons, cellSize, population
+ * Out args:  step (the counts of the cell are added to it)
+ */
+void computeCellNextStatus(const int *cellPersons, int cellSize, Population *population, StepStatistics *step) {
+    const uint8_t *status = population->status;
+    const uint8_t *statusDuration = population->statusDuration;
+    uint8_t *nextStatus = population->nextStatus;
+    int infected = 0, susceptible = 0, infectedExpired = 0, immuneExpired = 0;
+
+    // verifica fiecare persoana din celula
+    for(int k=0;k<cellSize;k++) {
+        int index = cellPersons[k];
+        switch(status[index]) {
+            case INFECTED: // daca este infectat il numara si daca durata a ajuns la 0 seteaza urmatoarea stare pe immune
+                infected++;
+                if(statusDuration[index] == 0) {
+                    nextStatus[index] = IMMUNE;
+                    infectedExpired++;
+                }
+                break;
+            case IMMUNE: // daca durata a ajuns la 0 seteaza pe susceptible la urmatoarea stare
+                if(statusDuration[index] == 0) {
+                    nextStatus[index] = SUSCEPTIBLE;
+                    immuneExpired++;
+                }
+                break;
+            case SUSCEPTIBLE: // doar numarat aici
+                susceptible++;
+                break;
+        }
+    }
+    
+    int newInfections = 0;
+    if(infected) { // daca o persoana este infectata vom infecta si celelalte persoane susceptibile din aceeasi celula
+        for(int k=0;k<cellSize;k++) {
+            if(status[cellPersons[k]] == SUSCEPTIBLE)
+                nextStatus[cellPersons[k]] = INFECTED;
+        }
+        newInfections = susceptible;
+    }
+
+    // starile de dupa pas: cine a expirat trece mai departe, susceptibilii infectati devin infectati
+    step->infected += infected - infectedExpired + newInfections;
+    step->susceptible += susceptible - newInfections + immuneExpired;
+    step->immune += cellSize - infected - susceptible - immuneExpired + infectedExpired;
+    step->newInfections += newInfections;
+    step->occupiedCells++;
+    if(cellSize > step->maxCellOccupancy) step->maxCellOccupancy = cellSize;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Update Status
+ * Purpose:   Update the status to next status of the person at index
+ * In args:   population, index, simulation (the durations of the statuses)
+ */
+void updateStatus(Population *population, int index, SimulationData *simulation) {
+    int status = population->nextStatus[index];
+    population->status[index] = status;
+    switch (status) {
+        case INFECTED:
+            if (population->statusDuration[index] == 0) {
+                population->statusDuration[index] = simulation->infectedDuration - 1;
+                population->infectionCounter[index]++;
+            }
+            else {
+                population->statusDuration[index]--;
+            }
+            break;
+        case SUSCEPTIBLE:
+            break;
+        case IMMUNE:
+            if (population->statusDuration[index] == 0) {
+                population->statusDuration[index] = simulation->immuneDuration;
+            }
+            else {
+                population->statusDuration[index]--;
+            }
+            break;
+        default:
+    }
+}
+
+void updateStatusScalar(Population *population, int first, int last, SimulationData *simulation) {
+    for(int i=first;i<last;i++) {
+        updateStatus(population, i, simulation);
+    }
+}
+
+void updateLocationScalar(Population *population, int first, int last, SimulationData *simulation) {
+    for(int i=first;i<last;i++) {
+        updateLocation(population, i, simulation);
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+/*-----------------------------------------------------------------
+ * Function:  Update Status AVX2
+ * Purpose:   Same as updateStatus for the persons in [first, last), 32 persons at a time: the switch on status becomes byte masks
+            (infected, immune, duration expired) and the new durations are picked with blends; the persons left at the end
+            go through updateStatus
+ * In args:   population, first, last
+ */
+__attribute__((target("avx2")))
+void updateStatusAVX2(Population *population, int first, int last, SimulationData *simulation) {
+    const __m256i infected = _mm256_set1_epi8(INFECTED);
+    const __m256i immune = _mm256_set1_epi8(IMMUNE);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i infectedDuration = _mm256_set1_epi8(simulation->infectedDuration - 1);
+    const __m256i immuneDuration = _mm256_set1_epi8(simulation->immuneDuration);
+
+    int i = first;
+    for(;i+32<=last;i+=32) {
+        __m256i nextStatus = _mm256_loadu_si256((const __m256i *)(population->nextStatus + i));
+        __m256i duration = _mm256_loadu_si256((const __m256i *)(population->statusDuration + i));
+
+        __m256i isInfected = _mm256_cmpeq_epi8(nextStatus, infected);
+        __m256i isImmune = _mm256_cmpeq_epi8(nextStatus, immune);
+        __m256i expired = _mm256_cmpeq_epi8(duration, zero);
+        __m256i newInfection = _mm256_and_si256(isInfected, expired);
+
+        // infectatii si imunii cu durata ramasa scad durata, cei cu durata 0 primesc durata starii noi
+        __m256i counting = _mm256_andnot_si256(expired, _mm256_or_si256(isInfected, isImmune));
+        duration = _mm256_blendv_epi8(duration, _mm256_sub_epi8(duration, one), counting);
+        duration = _mm256_blendv_epi8(duration, infectedDuration, newInfection);
+        duration = _mm256_blendv_epi8(duration, immuneDuration, _mm256_and_si256(isImmune, expired));
+
+        _mm256_storeu_si256((__m256i *)(population->status + i), nextStatus);
+        _mm256_storeu_si256((__m256i *)(population->statusDuration + i), duration);
+
+        if(!_mm256_testz_si256(newInfection, newInfection)) {
+            // masca are -1 pe octetii persoanelor nou infectate, deci scaderea ei creste infectionCounter
+            __m128i halves[2] = {_mm256_castsi256_si128(newInfection), _mm256_extracti128_si256(newInfection, 1)};
+            for(int q=0;q<4;q++) {
+                __m128i bytes = (q & 1) ? _mm_srli_si128(halves[q >> 1], 8) : halves[q >> 1];
+                int *counter = population->infectionCounter + i + 8 * q;
+                __m256i value = _mm256_loadu_si256((const __m256i *)counter);
+                value = _mm256_sub_epi32(value, _mm256_cvtepi8_epi32(bytes));
+                _mm256_storeu_si256((__m256i *)counter, value);
+            }
+        }
+    }
+
+    updateStatusScalar(population, i, last, simulation);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Update Location AVX2
+ * Purpose:   Same as updateLocation for the persons in [first, last), 16 persons at a time on 16 bit lanes: the moving coordinate
+            (x for NORTH/SOUTH, y for EAST/WEST) goes forward with a saturated add clamped to the last cell or backward with a saturated
+            subtract clamped to 0, and the direction is flipped where the clamp was hit; with WIDE_COORDINATES only the scalar loop is used
+ * In args:   population, first, last, simulation
+ */
+__attribute__((target("avx2")))
+void updateLocationAVX2(Population *population, int first, int last, SimulationData *simulation) {
+    int i = first;
+#ifndef WIDE_COORDINATES
+    const __m256i lastX = _mm256_set1_epi16((short)(simulation->maxXCoord - 1));
+    const __m256i lastY = _mm256_set1_epi16((short)(simulation->maxYCoord - 1));
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i two = _mm256_set1_epi16(2);
+    const __m256i four = _mm256_set1_epi16(4);
+
+    for(;i+16<=last;i+=16) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(population->x + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(population->y + i));
+        __m256i amplitude = _mm256_loadu_si256((const __m256i *)(population->movementAmplitude + i));
+        __m256i direction = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(population->movementDirection + i)));
+
+        __m256i vertical = _mm256_cmpgt_epi16(two, direction);                          // NORTH, SOUTH: se misca pe x
+        __m256i valid = _mm256_cmpgt_epi16(four, direction);                            // directiile necunoscute nu se misca
+        __m256i forward = _mm256_cmpeq_epi16(_mm256_and_si256(direction, one), zero);   // NORTH, EAST: coordonata creste
+
+        __m256i coord = _mm256_blendv_epi8(y, x, vertical);
+        __m256i limit = _mm256_blendv_epi8(lastY, lastX, vertical);
+
+        __m256i ahead = _mm256_adds_epu16(coord, amplitude);
+        __m256i aheadInside = _mm256_cmpeq_epi16(_mm256_subs_epu16(ahead, limit), zero);
+        __m256i behind = _mm256_subs_epu16(coord, amplitude);
+        __m256i behindInside = _mm256_cmpeq_epi16(_mm256_subs_epu16(amplitude, coord), zero);
+
+        __m256i newCoord = _mm256_blendv_epi8(behind, _mm256_min_epu16(ahead, limit), forward);
+        __m256i hit = _mm256_andnot_si256(_mm256_blendv_epi8(behindInside, aheadInside, forward), valid);
+
+        x = _mm256_blendv_epi8(x, newCoord, _mm256_and_si256(vertical, valid));
+        y = _mm256_blendv_epi8(y, newCoord, _mm256_andnot_si256(vertical, valid));
+        direction = _mm256_xor_si256(direction, _mm256_and_si256(hit, one));
+
+        _mm256_storeu_si256((__m256i *)(population->x + i), x);
+        _mm256_storeu_si256((__m256i *)(population->y + i), y);
+        _mm_storeu_si128((__m128i *)(population->movementDirection + i),
+                         _mm_packus_epi16(_mm256_castsi256_si128(direction), _mm256_extracti128_si256(direction, 1)));
+    }
+#endif
+
+    updateLocationScalar(population, i, last, simulation);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Update Status AVX512
+ * Purpose:   AVX-512 version of updateStatusAVX2: 64 persons at a time, with mask registers instead of blends
+ * In args:   population, first, last
+ */
+__attribute__((target("avx512f,avx512bw")))
+void updateStatusAVX512(Population *population, int first, int last, SimulationData *simulation) {
+    const __m512i infected = _mm512_set1_epi8(INFECTED);
+    const __m512i immune = _mm512_set1_epi8(IMMUNE);
+    const __m512i one = _mm512_set1_epi8(1);
+    const __m512i oneInt = _mm512_set1_epi32(1);
+    const __m512i infectedDuration = _mm512_set1_epi8(simulation->infectedDuration - 1);
+    const __m512i immuneDuration = _mm512_set1_epi8(simulation->immuneDuration);
+
+    int i = first;
+    for(;i+64<=last;i+=64) {
+        __m512i nextStatus = _mm512_loadu_si512(population->nextStatus + i);
+        __m512i duration = _mm512_loadu_si512(population->statusDuration + i);
+
+        __mmask64 isInfected = _mm512_cmpeq_epi8_mask(nextStatus, infected);
+        __mmask64 isImmune = _mm512_cmpeq_epi8_mask(nextStatus, immune);
+        __mmask64 expired = _mm512_testn_epi8_mask(duration, duration);
+        __mmask64 newInfection = isInfected & expired;
+
+        duration = _mm512_mask_sub_epi8(duration, (isInfected | isImmune) & ~expired, duration, one);
+        duration = _mm512_mask_mov_epi8(duration, newInfection, infectedDuration);
+        duration = _mm512_mask_mov_epi8(duration, isImmune & expired, immuneDuration);
+
+        _mm512_storeu_si512(population->status + i, nextStatus);
+        _mm512_storeu_si512(population->statusDuration + i, duration);
+
+        if(newInfection) {
+            for(int q=0;q<4;q++) {
+                int *counter = population->infectionCounter + i + 16 * q;
+                __m512i value = _mm512_loadu_si512(counter);
+                value = _mm512_mask_add_epi32(value, (__mmask16)(newInfection >> (16 * q)), value, oneInt);
+                _mm512_storeu_si512(counter, value);
+            }
+        }
+    }
+
+    updateStatusScalar(population, i, last, simulation);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Update Location AVX512
+ * Purpose:   AVX-512 version of updateLocationAVX2: 32 persons at a time, with mask registers instead of blends
+ * In args:   population, first, last, simulation
+ */
+__attribute__((target("avx512f,avx512bw")))
+void updateLocationAVX512(Population *population, int first, int last, SimulationData *simulation) {
+    int i = first;
+#ifndef WIDE_COORDINATES
+    const __m512i lastX = _mm512_set1_epi16((short)(simulation->maxXCoord - 1));
+    const __m512i lastY = _mm512_set1_epi16((short)(simulation->maxYCoord - 1));
+    const __m512i one = _mm512_set1_epi16(1);
+    const __m512i two = _mm512_set1_epi16(2);
+    const __m512i four = _mm512_set1_epi16(4);
+
+    for(;i+32<=last;i+=32) {
+        __m512i x = _mm512_loadu_si512(population->x + i);
+        __m512i y = _mm512_loadu_si512(population->y + i);
+        __m512i amplitude = _mm512_loadu_si512(population->movementAmplitude + i);
+        __m512i direction = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(population->movementDirection + i)));
+
+        __mmask32 vertical = _mm512_cmplt_epu16_mask(direction, two);
+        __mmask32 valid = _mm512_cmplt_epu16_mask(direction, four);
+        __mmask32 forward = _mm512_testn_epi16_mask(direction, one);
+
+        __m512i coord = _mm512_mask_blend_epi16(vertical, y, x);
+        __m512i limit = _mm512_mask_blend_epi16(vertical, lastY, lastX);
+
+        __m512i ahead = _mm512_adds_epu16(coord, amplitude);
+        __mmask32 aheadHit = _mm512_cmpgt_epu16_mask(ahead, limit);
+        __m512i behind = _mm512_subs_epu16(coord, amplitude);
+        __mmask32 behindHit = _mm512_cmpgt_epu16_mask(amplitude, coord);
+
+        __m512i newCoord = _mm512_mask_blend_epi16(forward, behind, _mm512_min_epu16(ahead, limit));
+        __mmask32 hit = ((forward & aheadHit) | (~forward & behindHit)) & valid;
+
+        x = _mm512_mask_blend_epi16(vertical & valid, x, newCoord);
+        y = _mm512_mask_blend_epi16(~vertical & valid, y, newCoord);
+        direction = _mm512_xor_si512(direction, _mm512_maskz_mov_epi16(hit, one));
+
+        _mm512_storeu_si512(population->x + i, x);
+        _mm512_storeu_si512(population->y + i, y);
+        _mm256_storeu_si256((__m256i *)(population->movementDirection + i), _mm512_cvtepi16_epi8(direction));
+    }
+#endif
+
+    updateLocationScalar(population, i, last, simulation);
+}
+#endif
+
+int kernelsSupported(int kernelType) {
+    switch(kernelType) {
+        case KERNELS_SCALAR:
+            return 1;
+#ifdef HAVE_X86_KERNELS
+        case KERNELS_AVX2:
+            return __builtin_cpu_supports("avx2");
+        case KERNELS_AVX512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+        default:
+            return 0;
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Get Kernels
+ * Purpose:   Return the status/location kernels of kernelType; KERNELS_AUTO picks the widest ones the processor supports
+ * In args:   kernelType
+ */
+UpdateKernels getKernels(int kernelType) {
+    if(kernelType == KERNELS_AUTO) {
+        if(kernelsSupported(KERNELS_AVX512)) {
+            kernelType = KERNELS_AVX512;
+        } else if(kernelsSupported(KERNELS_AVX2)) {
+            kernelType = KERNELS_AVX2;
+        } else {
+            kernelType = KERNELS_SCALAR;
+        }
+    }
+
+    if(!kernelsSupported(kernelType)) {
+        printf("Kernel-urile cerute nu sunt suportate de procesor\n");
+        exit(-1);
+    }
+
+    UpdateKernels result = {"scalar", updateStatusScalar, updateLocationScalar};
+#ifdef HAVE_X86_KERNELS
+    if(kernelType == KERNELS_AVX2) {
+        result = (UpdateKernels){"avx2", updateStatusAVX2, updateLocationAVX2};
+    } else if(kernelType == KERNELS_AVX512) {
+        result = (UpdateKernels){"avx512", updateStatusAVX512, updateLocationAVX512};
+    }
+#endif
+    return result;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Check Kernels
+ * Purpose:   Run every vectorized kernel the processor supports next to updateStatus/updateLocation and compare all the person arrays:
+            first on the loaded population for simulationTime steps, then for one step on random persons, which also reach
+            the walls, the expired durations and the unknown directions that an input file may not contain
+ * In args:   population, simulation
+ * Return:    the number of kernels that did not match the scalar functions
+ */
+int checkKernels(Population *population, SimulationData *simulation) {
+    int kernelTypes[] = {KERNELS_AVX2, KERNELS_AVX512};
+    int mismatches = 0;
+
+    for(int k=0;k<(int)(sizeof(kernelTypes) / sizeof(kernelTypes[0]));k++) {
+        if(!kernelsSupported(kernelTypes[k])) continue;
+        UpdateKernels tested = getKernels(kernelTypes[k]);
+
+        int n = simulation->numberOfPersons;
+        Population *reference = allocPopulation(n);
+        Population *candidate = allocPopulation(n);
+        CellIndex *grid = allocGrid(simulation, 1, GRID_AUTO);
+        copyPopulation(reference, population, n);
+        copyPopulation(candidate, population, n);
+
+        int failedStep = -1, failedPerson = -1;
+        for(int time=simulation->startStep;time<simulation->simulationTime && failedStep < 0;time++) {
+            updateGrid(grid, reference, simulation);
+            StepStatistics step = {0};
+            computeNextStatus(grid, reference, simulation, &step);
+            updateStatusScalar(reference, 0, n, simulation);
+            updateLocationScalar(reference, 0, n, simulation);
+
+            updateGrid(grid, candidate, simulation);
+            computeNextStatus(grid, candidate, simulation, &step);
+            tested.updateStatus(candidate, 0, n, simulation);
+            tested.updateLocation(candidate, 0, n, simulation);
+
+            failedPerson = comparePopulation(reference, candidate, n);
+            if(failedPerson >= 0) failedStep = time;
+        }
+        freeGrid(grid);
+        freePopulation(reference);
+        freePopulation(candidate);
+
+        // persoane aleatoare: toate combinatiile de stare, durata si directie, pornind de la un index nealiniat
+        int randomFailed = -1;
+        if(failedStep < 0) {
+            n = KERNEL_CHECK_PERSONS;
+            reference = allocPopulation(n);
+            candidate = allocPopulation(n);
+            srand(12345);
+            int maxCoord = simulation->maxXCoord > simulation->maxYCoord ? simulation->maxXCoord : simulation->maxYCoord;
+            for(int i=0;i<n;i++) {
+                reference->personID[i] = i + 1;
+                reference->x[i] = rand() % simulation->maxXCoord;
+                reference->y[i] = rand() % simulation->maxYCoord;
+                reference->status[i] = rand() % 3;
+                reference->nextStatus[i] = rand() % 3;
+                reference->statusDuration[i] = rand() % 3 == 0 ? 0 : rand() % (simulation->infectedDuration + 1);
+                reference->movementDirection[i] = rand() % 16 == 0 ? rand() % 256 : rand() % 4;
+                reference->movementAmplitude[i] = rand() % (2 * maxCoord < MAX_GRID_SIZE ? 2 * maxCoord + 1 : MAX_GRID_SIZE);
+                reference->infectionCounter[i] = rand() % 100;
+            }
+            copyPopulation(candidate, reference, n);
+
+            updateStatusScalar(reference, 3, n, simulation);
+            updateLocationScalar(reference, 3, n, simulation);
+            tested.updateStatus(candidate, 3, n, simulation);
+            tested.updateLocation(candidate, 3, n, simulation);
+            randomFailed = comparePopulation(reference, candidate, n);
+
+            freePopulation(reference);
+            freePopulation(candidate);
+        }
+
+        if(failedStep >= 0) {
+            printf("Kernels %s: MISMATCH at step %d, person index %d\n", tested.name, failedStep, failedPerson);
+            mismatches++;
+        } else if(randomFailed >= 0) {
+            printf("Kernels %s: MISMATCH on random persons, person index %d\n", tested.name, randomFailed);
+            mismatches++;
+        } else {
+            printf("Kernels %s: OK (%d steps, %d random persons)\n", tested.name, simulation->simulationTime - simulation->startStep, KERNEL_CHECK_PERSONS);
+        }
+    }
+
+    return mismatches;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Verify Engines
+ * Purpose:   Run simulateSerial and engine side by side on copies of population, every steps at a time, and compare all the fields
+            of all persons after each segment; on a difference the segment is replayed one step at a time from the last state
+            that matched, to find the first step and person that differ (if the replay matches, the engine is not deterministic)
+ * In args:   engine, serialGrid, parallelGrid, population, simulation, every
+ * Return:    the first step after which the populations differ, or -1 if they are identical up to simulationTime
+ */
+int verifyEngines(SimulationEngine engine, CellIndex *serialGrid, CellIndex *parallelGrid, Population *population, SimulationData *simulation,
+                  int every) {
+    int n = simulation->numberOfPersons;
+    Population *serial = allocPopulation(n);
+    Population *parallel = allocPopulation(n);
+    Population *matched = allocPopulation(n);
+    copyPopulation(serial, population, n);
+    copyPopulation(parallel, population, n);
+    copyPopulation(matched, population, n);
+
+    int failedStep = -1, person = -1;
+    SimulationData segment = *simulation;
+    while(segment.startStep < simulation->simulationTime && failedStep < 0) {
+        segment.simulationTime = segment.startStep + every < simulation->simulationTime ? segment.startStep + every : simulation->simulationTime;
+        simulateSerial(serialGrid, serial, &segment, NULL);
+        engine(parallelGrid, parallel, &segment, NULL);
+
+        if(comparePopulation(serial, parallel, n) < 0) {
+            copyPopulation(matched, serial, n);
+            segment.startStep = segment.simulationTime;
+            continue;
+        }
+
+        // reiau segmentul pas cu pas de la ultima stare identica
+        copyPopulation(serial, matched, n);
+        copyPopulation(parallel, matched, n);
+        SimulationData single = segment;
+        for(single.startStep=segment.startStep;single.startStep<segment.simulationTime;single.startStep++) {
+            single.simulationTime = single.startStep + 1;
+            simulateSerial(serialGrid, serial, &single, NULL);
+            engine(parallelGrid, parallel, &single, NULL);
+            person = comparePopulation(serial, parallel, n);
+            if(person >= 0) break;
+        }
+        failedStep = segment.simulationTime;
+        if(person < 0) {
+            printf("Verify: steps %d..%d differ when run together but not one at a time - the parallel engine is not deterministic\n",
+                   segment.startStep + 1, segment.simulationTime);
+        } else {
+            failedStep = single.simulationTime;
+            char line[2 * MAX_LINE_LENGTH];
+            char *cursor = line;
+            memcpy(cursor, "  serial:   ", 12);
+            cursor = formatPerson(cursor + 12, serial, person, STANDARD_PRINT_FORMAT);
+            memcpy(cursor, "  parallel: ", 12);
+            cursor = formatPerson(cursor + 12, parallel, person, STANDARD_PRINT_FORMAT);
+            *cursor = '\0';
+            printf("Verify: first difference after step %d, person %d (index %d, nextStatus %d / %d)\n%s", failedStep, serial->personID[person],
+                   person, serial->nextStatus[person], parallel->nextStatus[person], line);
+        }
+    }
+    if(failedStep < 0) {
+        printf("Verify: serial and parallel identical for steps %d..%d (compared every %d steps)\n", simulation->startStep + 1,
+               simulation->simulationTime, every);
+    }
+
+    freePopulation(serial);
+    freePopulation(parallel);
+    freePopulation(matched);
+    return failedStep;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Thread Range
+ * Purpose:   Split count elements between the threads of the current parallel region in blocks of blockSize elements
+            and return the interval [first, last) of the calling thread
+ * In args:   count, blockSize
+ * Out args:  first, last
+ */
+void threadRange(int count, int blockSize, int *first, int *last) {
+    blockRange(count, blockSize, omp_get_thread_num(), omp_get_num_threads(), first, last);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Block Range
+ * Purpose:   The split of threadRange for thread threadID of threadCount threads, outside of OpenMP
+ * In args:   count, blockSize, threadID, threadCount
+ * Out args:  first, last
+ */
+void blockRange(int count, int blockSize, int threadID, int threadCount, int *first, int *last) {
+    long long blocks = (count + blockSize - 1) / blockSize;
+
+    long long start = blocks * threadID / threadCount * blockSize;
+    long long end = blocks * (threadID + 1) / threadCount * blockSize;
+    *first = start < count ? (int)start : count;
+    *last = end < count ? (int)end : count;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Alloc Population
+ * Purpose:   Allocate the arrays of a population of numberOfPersons persons; every array starts on a cache line
+ * In args:   numberOfPersons
+ */
+Population *allocPopulation(int numberOfPersons) {
+    Population *population = tryAllocPopulation(numberOfPersons);
+    if(!population) {
+        printf("Eroare la alocare populatie\n");
+        exit(-1);
+    }
+
+    return population;
+}
+
+// allocPopulation care intoarce NULL daca memoria nu ajunge, in loc sa opreasca programul
+Population *tryAllocPopulation(int numberOfPersons) {
+    Population *population = malloc(sizeof(Population));
+    PROFILE_ALLOCATION();
+    if(!population) return NULL;
+
+    void **arrays[POPULATION_ARRAY_COUNT];
+    populationArrays(population, arrays);
+    size_t count = numberOfPersons > 0 ? numberOfPersons : 1;
+    int allocated = 1;
+    for(int k=0;k<POPULATION_ARRAY_COUNT;k++) {
+        *arrays[k] = tryAlignedArray(count, populationElementSize[k]);
+        if(!*arrays[k]) allocated = 0;
+    }
+    population->mapping = NULL;
+    population->mappingSize = 0;
+    if(!allocated) {
+        freePopulation(population);
+        return NULL;
+    }
+
+    return population;
+}
+
+void copyPopulation(Population *destination, Population *source, int numberOfPersons) {
+    void **destinationArrays[POPULATION_ARRAY_COUNT], **sourceArrays[POPULATION_ARRAY_COUNT];
+    populationArrays(destination, destinationArrays);
+    populationArrays(source, sourceArrays);
+    for(int k=0;k<POPULATION_ARRAY_COUNT;k++) {
+        memcpy(*destinationArrays[k], *sourceArrays[k], numberOfPersons * populationElementSize[k]);
+    }
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Population Arrays
+ * Purpose:   Give the addresses of the array pointers of a population, in a fixed order (the order of populationElementSize
+            and of the arrays in a binary snapshot), so all the arrays can be handled in one loop
+ * In args:   population
+ * Out args:  arrays
+ */
+void populationArrays(Population *population, void **arrays[POPULATION_ARRAY_COUNT]) {
+    arrays[0] = (void **)&population->personID;
+    arrays[1] = (void **)&population->x;
+    arrays[2] = (void **)&population->y;
+    arrays[3] = (void **)&population->status;
+    arrays[4] = (void **)&population->nextStatus;
+    arrays[5] = (void **)&population->statusDuration;
+    arrays[6] = (void **)&population->movementDirection;
+    arrays[7] = (void **)&population->movementAmplitude;
+    arrays[8] = (void **)&population->infectionCounter;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Check Population
+ * Purpose:   Check that the state of every person fits in the simulation (used for snapshots, which do not go through checkRow)
+ * In args:   population, simulation
+ * Return:    the index of the first invalid person, or -1 if all of them are valid
+ */
+int checkPopulation(Population *population, SimulationData *simulation) {
+    for(int i=0;i<simulation->numberOfPersons;i++) {
+        int negative = 0;
+#ifdef WIDE_COORDINATES
+        // coord_t are semn doar cu WIDE_COORDINATES
+        negative = population->x[i] < 0 || population->y[i] < 0 || population->movementAmplitude[i] < 0;
+#endif
+        if(negative || population->x[i] >= simulation->maxXCoord || population->y[i] >= simulation->maxYCoord ||
+           population->status[i] > IMMUNE || population->nextStatus[i] > IMMUNE || population->movementDirection[i] > WEST) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Compare Population
+ * Purpose:   Compare all the fields of two populations
+ * In args:   first, second, numberOfPersons
+ * Return:    the index of the first person that differs, or -1 if they are identical
+ */
+int comparePopulation(Population *first, Population *second, int numberOfPersons) {
+    for(int i=0;i<numberOfPersons;i++) {
+        if(first->personID[i] != second->personID[i] ||
+           first->x[i] != second->x[i] ||
+           first->y[i] != second->y[i] ||
+           first->status[i] != second->status[i] ||
+           first->nextStatus[i] != second->nextStatus[i] ||
+           first->statusDuration[i] != second->statusDuration[i] ||
+           first->movementDirection[i] != second->movementDirection[i] ||
+           first->movementAmplitude[i] != second->movementAmplitude[i] ||
+           first->infectionCounter[i] != second->infectionCounter[i]) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void freePopulation(Population *population) {
+    if(population->mapping) {
+        munmap(population->mapping, population->mappingSize);
+    } else {
+        void **arrays[POPULATION_ARRAY_COUNT];
+        populationArrays(population, arrays);
+        for(int k=0;k<POPULATION_ARRAY_COUNT;k++) {
+            free(*arrays[k]);
+        }
+    }
+    free(population);
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Aligned Array
+ * Purpose:   Allocate an array of count elements of elementSize bytes, aligned to CACHE_LINE_SIZE
+ * In args:   count, elementSize
+ */
+void *alignedArray(size_t count, size_t elementSize) {
+    void *array = tryAlignedArray(count, elementSize);
+    if(!array) {
+        printf("Eroare la alocare array de %zu elemente\n", count);
+        exit(-1);
+    }
+
+    return array;
+}
+
+// alignedArray care intoarce NULL daca memoria nu ajunge
+void *tryAlignedArray(size_t count, size_t elementSize) {
+    size_t size = (count * elementSize + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    void *array = aligned_alloc(CACHE_LINE_SIZE, size);
+    PROFILE_ALLOCATION();
+    return array;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Alloc Grid
+ * Purpose:   Allocate the cell index for the grid of the simulation; threadCount is the number of threads that will rebuild it in parallel;
+            a dense index needs memory for every cell of the grid (threadCount times), a sparse one only for every person,
+            so GRID_AUTO takes the sparse one when the grid has more than SPARSE_CELLS_PER_PERSON cells per person
+            or too many cells for an int id
+ * In args:   simulation, threadCount, gridType
+ */
+CellIndex *allocGrid(SimulationData *simulation, int threadCount, int gridType) {
+    char error[LOAD_ERROR_LENGTH];
+    CellIndex *grid = tryAllocGrid(simulation, threadCount, gridType, error);
+    if(!grid) {
+        printf("%s\n", error);
+        exit(-1);
+    }
+
+    return grid;
+}
+
+// allocGrid care intoarce NULL si motivul in error in loc sa opreasca programul
+CellIndex *tryAllocGrid(SimulationData *simulation, int threadCount, int gridType, char *error) {
+    long long cellCount = (long long)simulation->maxXCoord * simulation->maxYCoord;
+    if(cellCount <= 0 || (gridType == GRID_DENSE && cellCount >= INT_MAX)) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Dimensiune invalida pentru grid: %d x %d", simulation->maxXCoord, simulation->maxYCoord);
+        return NULL;
+    }
+    if(gridType == GRID_AUTO) {
+        gridType = cellCount >= INT_MAX || cellCount > (long long)SPARSE_CELLS_PER_PERSON * simulation->numberOfPersons ? GRID_SPARSE : GRID_DENSE;
+    }
+
+    CellIndex *grid = malloc(sizeof(CellIndex));
+    PROFILE_ALLOCATION();
+    if(!grid) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Eroare la alocare grid");
+        return NULL;
+    }
+
+    int n = simulation->numberOfPersons;
+    grid->firstRow = 0;
+    grid->threadCount = threadCount;
+    grid->active = NULL;
+    grid->team = NULL;
+    grid->personIndex = malloc(n * sizeof(int));
+    grid->occupiedCount = 0;
+
+    if(gridType == GRID_SPARSE) {
+        int keyBits = 1;
+        while(keyBits < 64 && ((uint64_t)(cellCount - 1) >> keyBits) != 0) keyBits++;
+
+        grid->sparse = 1;
+        grid->keyPasses = (keyBits + SPARSE_RADIX_BITS - 1) / SPARSE_RADIX_BITS;
+        grid->cellCount = 0;
+        grid->cellStart = malloc((n + 1) * sizeof(int));
+        grid->personCell = NULL;
+        grid->cellCursor = NULL;
+        grid->threadCellCount = malloc((size_t)threadCount * SPARSE_RADIX_BUCKETS * sizeof(int));
+        grid->occupiedCells = malloc((n + 1) * sizeof(int));
+        grid->personKey = malloc((n + 1) * sizeof(uint64_t));
+        grid->keyBuffer = malloc((n + 1) * sizeof(uint64_t));
+        grid->indexBuffer = malloc((n + 1) * sizeof(int));
+        if(!grid->cellStart || !grid->personIndex || !grid->threadCellCount || !grid->occupiedCells || !grid->personKey || !grid->keyBuffer ||
+           !grid->indexBuffer) {
+            snprintf(error, LOAD_ERROR_LENGTH, "Eroare la alocare index celule");
+            freeGrid(grid);
+            return NULL;
+        }
+        // celulele ocupate sunt numerotate de la 0, deci lista lor e mereu aceeasi
+        for(int c=0;c<=n;c++) {
+            grid->occupiedCells[c] = c;
+        }
+        grid->cellStart[0] = 0;
+        return grid;
+    }
+
+    grid->sparse = 0;
+    grid->keyPasses = 0;
+    grid->cellCount = (int)cellCount;
+    grid->cellStart = malloc((cellCount + 1) * sizeof(int));
+    grid->personCell = malloc(n * sizeof(int));
+    grid->cellCursor = malloc(cellCount * sizeof(int));
+    grid->threadCellCount = malloc((size_t)threadCount * cellCount * sizeof(int));
+    grid->occupiedCells = malloc((cellCount < n ? cellCount : n + 1) * sizeof(int));
+    grid->personKey = NULL;
+    grid->keyBuffer = NULL;
+    grid->indexBuffer = NULL;
+    if(!grid->cellStart || !grid->personIndex || !grid->personCell || !grid->cellCursor || !grid->threadCellCount || !grid->occupiedCells) {
+        snprintf(error, LOAD_ERROR_LENGTH, "Eroare la alocare index celule");
+        freeGrid(grid);
+        return NULL;
+    }
+
+    return grid;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Alloc Active Set
+ * Purpose:   Allocate the lists of simulateParallelActive for numberOfPersons persons and threadCount threads; the table has room
+            for the cells of all persons, at most half full
+ * In args:   numberOfPersons, threadCount
+ */
+ActiveSet *allocActiveSet(int numberOfPersons, int threadCount) {
+    ActiveSet *active = tryAllocActiveSet(numberOfPersons, threadCount);
+    if(!active) {
+        printf("Eroare la alocare lista de persoane active\n");
+        exit(-1);
+    }
+
+    return active;
+}
+
+// allocActiveSet care intoarce NULL daca memoria nu ajunge, in loc sa opreasca programul
+ActiveSet *tryAllocActiveSet(int numberOfPersons, int threadCount) {
+    int tableBits = 1;
+    while((1LL << tableBits) < 2LL * numberOfPersons || (1 << tableBits) < ACTIVE_TABLE_MIN_SIZE) tableBits++;
+
+    ActiveSet *active = malloc(sizeof(ActiveSet));
+    PROFILE_ALLOCATION();
+    if(!active) return NULL;
+    active->count = 0;
+    active->infectedCount = 0;
+    active->tableBits = tableBits;
+    active->persons = malloc((numberOfPersons + 1) * sizeof(int));
+    active->scratch = malloc((numberOfPersons + 1) * sizeof(int));
+    active->threadFound = malloc(threadCount * sizeof(int));
+    active->cellKeys = malloc(((size_t)1 << tableBits) * sizeof(uint64_t));
+    if(!active->persons || !active->scratch || !active->threadFound || !active->cellKeys) {
+        freeActiveSet(active);
+        return NULL;
+    }
+
+    return active;
+}
+
+void freeActiveSet(ActiveSet *active) {
+    free(active->persons);
+    free(active->scratch);
+    free(active->threadFound);
+    free(active->cellKeys);
+    free(active);
+}
+
+void freeGrid(CellIndex *grid) {
+    free(grid->cellStart);
+    free(grid->personIndex);
+    free(grid->personCell);
+    free(grid->cellCursor);
+    free(grid->threadCellCount);
+    free(grid->occupiedCells);
+    free(grid->personKey);
+    free(grid->keyBuffer);
+    free(grid->indexBuffer);
+    if(grid->active) freeActiveSet(grid->active);
+    if(grid->team) stopPthreadsTeam(grid->team);
+    free(grid);
+}
+
+// for version 1
+// void computeNextStatus(Person *person, int index, SimulationData *simulation) {
+//     switch (person[index].status) {
+//         case INFECTED:
+//             for (int i=0; i<simulation->numberOfPersons; i++) {
+//                 if (i != index) {
+//                     if (person[i].status == SUSCEPTIBLE) {
+//                         if (person[i].coord.x == person[index].coord.x) {
+//                             if (person[i].coord.y == person[index].coord.y) {
+//                                 person[i].nextStatus = INFECTED;
+//                             }
+//                         }
+//                     }
+//                 }
+//             }
+//             if (person[index].statusDuration == 0) {
+//                 person[index].nextStatus = IMMUNE;
+//             }
+//             break;
+//         case IMMUNE:
+//             if (person[index].statusDuration == 0) {
+//                 person[index].nextStatus = SUSCEPTIBLE;
+//             }
+//             break;
+//         case SUSCEPTIBLE:
+//             break;
+//         default:
+//     }
+// }
@@ -0,0 +1,155 @@
+/**
+ * Test of the simulation server: a LOAD of an invalid input must be answered with ERROR and the server must keep serving,
+ * so that a valid LOAD and a RUN work on the same server; RUN must refuse threads over the threads of the server and
+ * steps that would take the population past INT_MAX; the server can only write SERVER_FILE_LIMIT bytes in a file, so the
+ * RESULT and the RUN stats of a larger population fail like on a full disk and must be answered with ERROR too
+ * Usage: ./test_server validInput
+ */
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "epidemics.h"
+
+// o persoana in afara grid-ului de 1x1, refuzata de personScan
+#define INVALID_INPUT "1 1\n1\n1 5 5 0 0 1\n"
+#define LARGE_PERSONS 1000
+#define SERVER_FILE_LIMIT 4096
+
+int testConnect(const char *socketPath);
+int testCommand(int fd, const char *command, const char *expected);
+
+int main(int argc, char *argv[]) {
+    if(argc != 2) {
+        printf("Usage: %s validInput\n", argv[0]);
+        return 1;
+    }
+
+    char socketPath[64], invalidPath[64], largePath[64];
+    snprintf(socketPath, sizeof(socketPath), "/tmp/epidemics_test_%d.sock", (int)getpid());
+    snprintf(invalidPath, sizeof(invalidPath), "/tmp/epidemics_test_%d.txt", (int)getpid());
+    snprintf(largePath, sizeof(largePath), "/tmp/epidemics_test_%d_large.txt", (int)getpid());
+    FILE *invalid = fopen(invalidPath, "w");
+    FILE *large = fopen(largePath, "w");
+    if(!invalid || !large) {
+        perror("fopen");
+        return 1;
+    }
+    fputs(INVALID_INPUT, invalid);
+    fclose(invalid);
+    // o populatie al carei rezultat depaseste SERVER_FILE_LIMIT
+    fprintf(large, "100 100\n%d\n", LARGE_PERSONS);
+    for(int i=0;i<LARGE_PERSONS;i++) {
+        fprintf(large, "%d %d %d %d %d %d\n", i + 1, i % 100, i * 7 % 100, i % 3, i % 4, 1 + i % 5);
+    }
+    fclose(large);
+
+    pid_t child = fork();
+    if(child < 0) {
+        perror("fork");
+        return 1;
+    }
+    if(child == 0) {
+        // o scriere peste limita intoarce EFBIG, ca ENOSPC pe un disc plin
+        struct rlimit limit = {SERVER_FILE_LIMIT, SERVER_FILE_LIMIT};
+        signal(SIGXFSZ, SIG_IGN);
+        setrlimit(RLIMIT_FSIZE, &limit);
+        kernels = getKernels(KERNELS_AUTO);
+        exit(runServer(socketPath, 1));
+    }
+
+    int fd = testConnect(socketPath);
+    int failures = fd < 0;
+    if(fd >= 0) {
+        char command[1024];
+        snprintf(command, sizeof(command), "LOAD %s\n", invalidPath);
+        failures += testCommand(fd, command, "ERROR");
+        snprintf(command, sizeof(command), "LOAD %s\n", argv[1]);
+        failures += testCommand(fd, command, "OK 0 ");
+        failures += testCommand(fd, "RUN 0 5 1\n", "OK 5 ");
+        failures += testCommand(fd, "RUN 0 1 999\n", "ERROR");
+        failures += testCommand(fd, "RUN 0 2147483647 1\n", "ERROR");
+        failures += testCommand(fd, "RUN 0 99999999999 1\n", "ERROR");
+        snprintf(command, sizeof(command), "LOAD %s\n", largePath);
+        failures += testCommand(fd, command, "OK 1 ");
+        failures += testCommand(fd, "RESULT 1\n", "ERROR");
+        failures += testCommand(fd, "RESULT 1 binary\n", "ERROR");
+        failures += testCommand(fd, "RUN 1 500 1 stats\n", "ERROR");
+        failures += testCommand(fd, "RUN 1 5 1 active\n", "OK 505 ");
+        failures += testCommand(fd, "RUN 1 5 1 pthreads\n", "OK 510 ");
+        failures += testCommand(fd, "LIST\n", "OK 2");
+        failures += testCommand(fd, "SHUTDOWN\n", "OK");
+        close(fd);
+    } else {
+        kill(child, SIGTERM);
+    }
+
+    int status;
+    waitpid(child, &status, 0);
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        printf("Serverul s-a oprit cu starea %d\n", status);
+        failures++;
+    }
+    unlink(invalidPath);
+    unlink(largePath);
+    unlink(socketPath);
+
+    printf("%s (%d erori)\n", failures ? "FAILED" : "OK", failures);
+    return failures != 0;
+}
+
+// conectare la server, reincercand cat timp socket-ul nu exista inca
+int testConnect(const char *socketPath) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", socketPath);
+
+    for(int attempt=0;attempt<500;attempt++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(fd < 0) {
+            perror("socket");
+            return -1;
+        }
+        if(connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0) return fd;
+        close(fd);
+        usleep(10000);
+    }
+    printf("Nu s-a putut face conectarea la %s\n", socketPath);
+    return -1;
+}
+
+/*-----------------------------------------------------------------
+ * Function:  Test Command
+ * Purpose:   Send command to the server and check that the last line of the answer ("OK ..." or "ERROR ...", after the
+            POPULATION lines of LIST) starts with expected; the commands that send a payload are only used when they fail
+ * In args:   fd, command, expected
+ * Return:    0 if the answer is the expected one, 1 otherwise
+ */
+int testCommand(int fd, const char *command, const char *expected) {
+    if(sendAll(fd, command, strlen(command)) != 0) {
+        printf("%s: nu s-a putut trimite\n", command);
+        return 1;
+    }
+
+    char line[1024];
+    do {
+        size_t length = 0;
+        while(length < sizeof(line) - 1) {
+            ssize_t got = read(fd, line + length, 1);
+            if(got <= 0) {
+                line[length] = '\0';
+                printf("%s: serverul a inchis conexiunea\n", command);
+                return 1;
+            }
+            if(line[length] == '\n') break;
+            length++;
+        }
+        line[length] = '\0';
+    } while(strncmp(line, "OK", 2) != 0 && strncmp(line, "ERROR", 5) != 0);
+
+    int ok = strncmp(line, expected, strlen(expected)) == 0;
+    printf("%-24.*s -> %s\n", (int)strcspn(command, "\n"), command, line);
+    if(!ok) printf("    asteptat: %s...\n", expected);
+    return !ok;
+}